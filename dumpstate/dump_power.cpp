@@ -14,12 +14,16 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <cstring>
-#include <dirent.h>
-#include <dump/pixel_dump.h>
+#include <fcntl.h>
 #include <fstream>
+#include <inttypes.h>
 #include <stdio.h>
+#include <signal.h>
+#include <spawn.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 #include <sys/sysinfo.h>
 #include <sys/wait.h>
 #include <time.h>
@@ -29,73 +33,59 @@
 #include <android-base/file.h>
 #include <android-base/strings.h>
 #include "DumpstateUtil.h"
-
+#include "dump_power_batch.h"
+#include "dump_power_cpuidle.h"
+#include "dump_power_delta.h"
+#include "dump_power_discovery.h"
+#include "dump_power_hexdump.h"
+#include "dump_power_history.h"
+#include "dump_power_io.h"
+#include "dump_power_output.h"
+#include "dump_power_profile.h"
+#include "dump_power_record.h"
+#include "dump_power_regmap.h"
+#include "dump_power_runner.h"
+#include "dump_power_sections.h"
+#include "dump_power_table.h"
+
+/* Device topology the sections probe; the resident service keeps it cached. */
+const char *powerSupplyDir = "/sys/class/power_supply/";
+const char *tcpmPsyMatch = "tcpm-source-psy-";
+const char *maxfgLoc = "/sys/class/power_supply/maxfg";
+const char *debugfsDir = "/d/";
+const char *maxFgDebugDir = "/d/maxfg";
+const char *maxFgStrMatch = "maxfg";
+const char *maxFg77779StrMatch = "max77779fg";
 
 void printTitle(const char *msg) {
-    printf("\n------ %s ------\n", msg);
-}
-
-int getCommandOutput(const char *cmd, std::string *output) {
-    char buffer[1024];
-    FILE *pipe = popen(cmd, "r");
-    if (!pipe) {
-        return -1;
-    }
-
-    while (fgets(buffer, sizeof buffer, pipe) != NULL) {
-        *output += buffer;
-    }
-    pclose(pipe);
-
-    if (output->back() == '\n')
-        output->pop_back();
-
-    return 0;
+    dumpPrintf("\n------ %s ------\n", msg);
 }
 
 bool isValidFile(const char *file) {
-    FILE *fp = fopen(file, "r");
-    if (fp != NULL) {
-        fclose(fp);
-        return true;
-    }
-    return false;
+    DumpNode node(file);
+    return node.ok();
 }
 
 bool isValidDir(const char *directory) {
-    DIR *dir = opendir(directory);
-    if (dir == NULL)
-        return false;
-
-    closedir(dir);
-    return true;
+    NodeDir dir(directory);
+    return dir.ok();
 }
 
 bool isUserBuild() {
-    return ::android::os::dumpstate::PropertiesHelper::IsUserBuild();
-}
-
-int getFilesInDir(const char *directory, std::vector<std::string> *files) {
-    std::string content;
-    struct dirent *entry;
-
-    DIR *dir = opendir(directory);
-    if (dir == NULL)
-        return -1;
-
-    files->clear();
-    while ((entry = readdir(dir)) != NULL)
-        files->push_back(entry->d_name);
-    closedir(dir);
-
-    sort(files->begin(), files->end());
-    return 0;
+    /*
+     * Sections call this from the runner's worker threads, and PropertiesHelper fills its cached
+     * build type without a lock, so it's only asked once, under the static's init guard.
+     */
+    static const bool userBuild = ::android::os::dumpstate::PropertiesHelper::IsUserBuild();
+    return userBuild;
 }
 
 void dumpPowerStatsTimes() {
     const char *title = "Power Stats Times";
     char rBuff[128];
+    char bootBuff[32];
     struct timespec rTs;
+    struct tm nowTime;
     struct sysinfo info;
     int ret;
 
@@ -109,40 +99,33 @@ void dumpPowerStatsTimes() {
     if (ret)
         return;
 
-    struct tm *nowTime = std::localtime(&rTs.tv_sec);
+    /* The reentrant variants, as other sections may format times on other threads. */
+    localtime_r(&rTs.tv_sec, &nowTime);
 
-    std::strftime(rBuff, sizeof(rBuff), "%m/%d/%Y %H:%M:%S", nowTime);
-    printf("Boot: %s", ctime(&boottime));
-    printf("Now: %s\n", rBuff);
+    std::strftime(rBuff, sizeof(rBuff), "%m/%d/%Y %H:%M:%S", &nowTime);
+    dumpPrintf("Boot: %s", ctime_r(&boottime, bootBuff));
+    dumpPrintf("Now: %s\n", rBuff);
 }
 
 int readContentsOfDir(const char* title, const char* directory, const char* strMatch,
         bool useStrMatch = false, bool printDirectory = false) {
-    std::vector<std::string> files;
     std::string content;
-    std::string fileLocation;
-    int ret;
 
-    ret = getFilesInDir(directory, &files);
-    if (ret < 0)
-        return ret;
+    NodeDir dir(directory);
+    if (!dir.ok())
+        return -1;
 
     printTitle(title);
-    for (auto &file : files) {
-        if (useStrMatch && std::string::npos == std::string(file).find(strMatch)) {
-            continue;
-        }
-
-        fileLocation = std::string(directory) + std::string(file);
-        if (!android::base::ReadFileToString(fileLocation, &content)) {
+    for (const char *file : dir.list(useStrMatch ? NodeDir::SUBSTRING : NodeDir::ANY, strMatch)) {
+        if (!readNodeToString(dir, file, &content)) {
             continue;
         }
         if (printDirectory) {
-            printf("\n\n%s\n", fileLocation.c_str());
+            dumpPrintf("\n\n%s\n", dir.pathOf(file).c_str());
         }
         if (content.back() == '\n')
             content.pop_back();
-        printf("%s\n", content.c_str());
+        dumpPrintf("%s\n", content.c_str());
     }
     return 0;
 }
@@ -154,30 +137,12 @@ void dumpAcpmStats() {
     readContentsOfDir(acpmTitle, acpmDir, statsSubStr, true, true);
 }
 
-void dumpTcpmPsyUevent() {
-    const char* tcpmPsy = "tcpm-source-psy-";
-    DIR *dir = opendir("/sys/class/power_supply/");
-    struct dirent *entry;
-
-    if (dir == NULL)
-        return;
-
-    while ((entry = readdir(dir)) != NULL) {
-        if (std::string::npos != std::string(entry->d_name).find(tcpmPsy)) {
-            std::string fullPath("/sys/class/power_supply/" + (const std::string)entry->d_name +
-                                 "/uevent");
-            dumpFileContent("Power supply property tcpm", fullPath.c_str());
-            break;
-        }
-    }
-
-    closedir(dir);
-}
-
 void dumpPowerSupplyStats() {
     const char* dumpList[][2] = {
             {"CPU PM stats", "/sys/devices/system/cpu/cpupm/cpupm/time_in_state"},
             {"GENPD summary", "/d/pm_genpd/pm_genpd_summary"},
+    };
+    const char* powerSupplyList[][2] = {
             {"Power supply property battery", "/sys/class/power_supply/battery/uevent"},
             {"Power supply property dc", "/sys/class/power_supply/dc/uevent"},
             {"Power supply property gcpm", "/sys/class/power_supply/gcpm/uevent"},
@@ -187,17 +152,90 @@ void dumpPowerSupplyStats() {
             {"Power supply property usb", "/sys/class/power_supply/usb/uevent"},
             {"Power supply property wireless", "/sys/class/power_supply/wireless/uevent"},
     };
+    const char *tcpmTitle = "Power supply property tcpm";
+    const char *readTimesTitle = "Power supply read times";
+    std::vector<std::string> titles;
+    std::string content;
 
     for (const auto &row : dumpList) {
         dumpFileContent(row[0], row[1]);
     }
 
-    dumpTcpmPsyUevent();
+    /* The charge path is read as one batch, so that its values are sampled together. */
+    NodeBatch batch;
+    for (const auto &row : powerSupplyList) {
+        titles.push_back(row[0]);
+        batch.add(row[1]);
+    }
+    for (const std::string &entry : discoverEntries(powerSupplyDir, tcpmPsyMatch)) {
+        titles.push_back(tcpmTitle);
+        batch.add(powerSupplyDir + entry + "/uevent");
+        break;
+    }
+    batch.read();
+
+    for (size_t i = 0; i < batch.size(); i++) {
+        const bool read = batch.get(i, &content);
+        dumpNodeContent(titles[i].c_str(), batch.path(i).c_str(), read ? &content : nullptr);
+    }
+
+    /* CLOCK_BOOTTIME around every read, and the skew from the first start to the last end. */
+    int64_t firstNs = INT64_MAX;
+    int64_t lastNs = 0;
+    bool titled = false;
+    for (size_t i = 0; i < batch.size(); i++) {
+        int64_t startNs;
+        int64_t endNs;
+        if (!batch.readTime(i, &startNs, &endNs))
+            continue;
+        firstNs = std::min(firstNs, startNs);
+        lastNs = std::max(lastNs, endNs);
+
+        const std::string path = batch.path(i);
+        if (structuredOutput()) {
+            dumpRecord(titles[i] + ".read_start_ns", startNs, path);
+            dumpRecord(titles[i] + ".read_end_ns", endNs, path);
+            continue;
+        }
+        if (!titled) {
+            printTitle(readTimesTitle);
+            titled = true;
+        }
+        dumpPrintf("%s: %" PRId64 ".%09" PRId64 " - %" PRId64 ".%09" PRId64 "\n", path.c_str(),
+                   startNs / 1000000000, startNs % 1000000000, endNs / 1000000000,
+                   endNs % 1000000000);
+    }
+    if (!lastNs)
+        return;
+    if (structuredOutput())
+        dumpRecord(std::string(readTimesTitle) + ".skew_ns", lastNs - firstNs, powerSupplyDir);
+    else
+        dumpPrintf("skew: %" PRId64 " us\n", (lastNs - firstNs) / 1000);
 }
 
-void dumpMaxFg() {
-    const char *maxfgLoc = "/sys/class/power_supply/maxfg";
+/*
+ * A registers_dump node is decoded with the map of the fuel gauge named by the
+ * device/name node next to it, so a gauge without a verified map, such as the
+ * max77779fg, keeps its plain dump.
+ */
+void dumpMaxFgFile(const char *title, const char *file) {
+    std::string_view path(file);
+    std::string name;
+
+    if (!android::base::EndsWith(path, "/registers_dump")) {
+        dumpFileContent(title, file);
+        return;
+    }
 
+    path.remove_suffix(strlen("registers_dump"));
+    if (!readNodeToString(std::string(path) + "device/name", &name)) {
+        dumpFileContent(title, file);
+        return;
+    }
+    dumpRegisterFile(title, file, findRegisterMap(android::base::Trim(name)));
+}
+
+void dumpMaxFg() {
     const char *maxfg [][2] = {
             {"Power supply property maxfg", "/sys/class/power_supply/maxfg/uevent"},
             {"maxfg registers", "/sys/class/power_supply/maxfg/registers_dump"},
@@ -224,13 +262,13 @@ void dumpMaxFg() {
     std::string content;
 
 
-    if (isValidDir(maxfgLoc)) {
+    if (discoverDir(maxfgLoc)) {
         for (const auto &row : maxfg) {
-            dumpFileContent(row[0], row[1]);
+            dumpMaxFgFile(row[0], row[1]);
         }
     } else {
         for (const auto &row : maxfgFlip) {
-            dumpFileContent(row[0], row[1]);
+            dumpMaxFgFile(row[0], row[1]);
         }
     }
 
@@ -250,18 +288,15 @@ void dumpPowerSupplyDock() {
 void dumpLogBufferTcpm() {
     const char* logbufferTcpmTitle = "Logbuffer TCPM";
     const char* logbufferTcpmFile = "/dev/logbuffer_tcpm";
-    const char* debugTcpmFile = "/sys/kernel/debug/tcpm";
     const char* tcpmLogTitle = "TCPM logs";
-    const char* tcpmFile = "/sys/kernel/debug/tcpm";
-    const char* tcpmFileAlt = "/sys/kernel/debug/usb/tcpm";
-    int retCode;
 
     dumpFileContent(logbufferTcpmTitle, logbufferTcpmFile);
 
-    retCode = readContentsOfDir(tcpmLogTitle, isValidFile(debugTcpmFile) ? tcpmFile : tcpmFileAlt,
-            NULL);
-    if (retCode < 0)
-        printTitle(tcpmLogTitle);
+    /*
+     * The tcpm debugfs logs are consumed when read, so they are left to their
+     * owner; the section has always only carried their title.
+     */
+    printTitle(tcpmLogTitle);
 }
 
 void dumpTcpc() {
@@ -288,19 +323,24 @@ void dumpTcpc() {
     std::string content;
     std::string tcpcRegistersPath(std::string(directory) + "/registers");
 
-    dumpFileContent("TCPC Registers", tcpcRegistersPath.c_str());
+    dumpRegisterFile("TCPC Registers", tcpcRegistersPath.c_str(), findRegisterMap("tcpci"));
 
     printTitle(max77759TcpcHead);
 
-    for (auto& tcpcVal : max77759Tcpc) {
-        std::string filename = std::string(directory) + "/" + std::string(tcpcVal);
-        printf("%s: ", tcpcVal);
-        android::base::ReadFileToString(filename, &content);
+    NodeBatch batch;
+    for (auto& tcpcVal : max77759Tcpc)
+        batch.add(std::string(directory) + "/" + std::string(tcpcVal));
+    batch.read();
+
+    for (size_t i = 0; i < batch.size(); i++) {
+        dumpPrintf("%s: ", max77759Tcpc[i]);
+        batch.get(i, &content);
         if (!content.empty() && (content.back() == '\n' || content.back() == '\r'))
             content.pop_back();
-        printf("%s\n", content.c_str());
+        dumpPrintf("%s\n", content.c_str());
+        dumpRecordValue(max77759Tcpc[i], content, batch.path(i));
     }
-    printf("\n");
+    dumpPrintf("\n");
 }
 
 void dumpPdEngine() {
@@ -369,73 +409,53 @@ void dumpBatteryDefend() {
             {"TEMP-DEFEND Config", "/sys/devices/platform/google,charger/", "bd_"},
     };
 
-    std::vector<std::string> files;
-    struct dirent *entry;
     std::string content;
-    std::string fileLocation;
 
     for (auto &config : defendConfig) {
-        DIR *dir = opendir(config[1]);
-        if (dir == NULL)
+        NodeDir dir(config[1]);
+        if (!dir.ok())
             continue;
 
         printTitle(config[0]);
-        while ((entry = readdir(dir)) != NULL) {
-            if (std::string(entry->d_name).find(config[2]) != std::string::npos &&
-                    strncmp(config[2], entry->d_name, strlen(config[2])) == 0) {
-                files.push_back(entry->d_name);
-            }
-        }
-        closedir(dir);
-
-        sort(files.begin(), files.end());
-
-        for (auto &file : files) {
-            fileLocation = std::string(config[1]) + std::string(file);
-            if (!android::base::ReadFileToString(fileLocation, &content) || content.empty()) {
+        for (const char *file : dir.list(NodeDir::PREFIX, config[2])) {
+            if (!readNodeToString(dir, file, &content) || content.empty()) {
                 content = "\n";
             }
 
-            printf("%s: %s", file.c_str(), content.c_str());
+            dumpPrintf("%s: %s", file, content.c_str());
+            dumpRecordValue(std::string(config[0]) + "." + file, android::base::Trim(content),
+                    dir.pathOf(file));
 
             if (content.back() != '\n')
-                printf("\n");
+                dumpPrintf("\n");
         }
-
-        files.clear();
     }
 }
 
 void printValuesOfDirectory(const char *directory, std::string debugfs, const char *strMatch) {
-    std::vector<std::string> files;
     auto info = directory;
     std::string content;
-    struct dirent *entry;
-    DIR *dir = opendir(debugfs.c_str());
-    if (dir == NULL)
+    if (!discoverDir(debugfs.c_str()))
         return;
 
     printTitle((debugfs + std::string(strMatch) + "/" + std::string(info)).c_str());
-    while ((entry = readdir(dir)) != NULL)
-        if (std::string(entry->d_name).find(strMatch) != std::string::npos)
-            files.push_back(entry->d_name);
-    closedir(dir);
+    const std::vector<std::string> files = discoverEntries(debugfs.c_str(), strMatch);
 
-    sort(files.begin(), files.end());
+    NodeBatch batch;
+    for (const std::string &file : files)
+        batch.add(debugfs + file + "/" + info);
+    batch.read();
 
-    for (auto &file : files) {
-        std::string fileDirectory = debugfs + file;
-        std::string fileLocation = fileDirectory + "/" + std::string(info);
-        if (!android::base::ReadFileToString(fileLocation, &content)) {
+    for (size_t i = 0; i < files.size(); i++) {
+        if (!batch.get(i, &content)) {
             content = "\n";
         }
 
-        printf("%s:\n%s", fileDirectory.c_str(), content.c_str());
+        dumpPrintf("%s:\n%s", (debugfs + files[i]).c_str(), content.c_str());
 
         if (content.back() != '\n')
-            printf("\n");
+            dumpPrintf("\n");
     }
-    files.clear();
 }
 
 void dumpChg() {
@@ -451,9 +471,9 @@ void dumpChg() {
     std::string chg_name;
     std::string pmic_name;
 
-    printf("\n");
+    dumpPrintf("\n");
 
-    int ret = android::base::ReadFileToString(chg_name_cmd, &chg_name);
+    int ret = readNodeToString(chg_name_cmd, &chg_name);
     if (ret && !chg_name.empty()) {
         chg_name.erase(chg_name.length() - 1); // remove new line
         const std::string chg_reg_dump_title = chg_name + reg_dump_str;
@@ -462,7 +482,7 @@ void dumpChg() {
         dumpFileContent(chg_reg_dump_title.c_str(), chg_reg_dump_file);
     }
 
-    ret = android::base::ReadFileToString(pmic_name_cmd, &pmic_name);
+    ret = readNodeToString(pmic_name_cmd, &pmic_name);
     if (ret && !pmic_name.empty()) {
         pmic_name.erase(pmic_name.length() - 1); // remove new line
         const std::string pmic_reg_dump_title = pmic_name + reg_dump_str;
@@ -477,10 +497,7 @@ void dumpChg() {
 }
 
 void dumpChgUserDebug() {
-    const std::string debugfs = "/d/";
-    const char *maxFgDir = "/d/maxfg";
-    const char *maxFgStrMatch = "maxfg";
-    const char *maxFg77779StrMatch = "max77779fg";
+    const std::string debugfs = debugfsDir;
     const char *chgTblName = "Charging table dump";
     const char *chgTblDir = "/d/google_battery/chg_raw_profile";
 
@@ -505,7 +522,7 @@ void dumpChgUserDebug() {
 
     dumpFileContent(chgTblName, chgTblDir);
 
-    if (isValidDir(maxFgDir)) {
+    if (discoverDir(maxFgDebugDir)) {
         for (auto & directory : maxFgInfo) {
             printValuesOfDirectory(directory, debugfs, maxFgStrMatch);
         }
@@ -516,26 +533,26 @@ void dumpChgUserDebug() {
     }
 }
 
+void warmTopology() {
+    discoverEntries(powerSupplyDir, tcpmPsyMatch);
+    discoverDir(maxfgLoc);
+    if (isUserBuild())
+        return;
+    discoverDir(debugfsDir);
+    discoverDir(maxFgDebugDir);
+    discoverEntries(debugfsDir, maxFgStrMatch);
+    discoverEntries(debugfsDir, maxFg77779StrMatch);
+}
+
 void dumpBatteryEeprom() {
     const char *title = "Battery EEPROM";
     const char *files[] {
             "/sys/devices/platform/10c90000.hsi2c/i2c-9/9-0050/eeprom",
     };
-    std::string result;
-    std::string xxdCmd;
 
     printTitle(title);
     for (auto &file : files) {
-        if (!isValidFile(file))
-            continue;
-
-        xxdCmd = "xxd " + std::string(file);
-
-        int ret = getCommandOutput(xxdCmd.c_str(), &result);
-        if (ret < 0)
-            return;
-
-        printf("%s\n", result.c_str());
+        dumpHexFile(file);
     }
 }
 
@@ -546,9 +563,7 @@ void dumpChargerStats() {
             {"Google Charger", "/sys/kernel/debug/google_charger/", "pps_"},
             {"Google Battery", "/sys/kernel/debug/google_battery/", "ssoc_"},
     };
-    std::vector<std::string> files;
     std::string content;
-    struct dirent *entry;
 
     dumpFileContent(chgStatsTitle, chgStatsLocation);
 
@@ -556,30 +571,30 @@ void dumpChargerStats() {
         return;
 
     for (auto &stat : chargerStats) {
-        DIR *dir = opendir(stat[1]);
-        if (dir == NULL)
+        NodeDir dir(stat[1]);
+        if (!dir.ok())
             return;
 
         printTitle(stat[0]);
-        while ((entry = readdir(dir)) != NULL)
-            if (std::string(entry->d_name).find(stat[2]) != std::string::npos)
-                files.push_back(entry->d_name);
-        closedir(dir);
+        const std::vector<const char *> &files = dir.list(NodeDir::SUBSTRING, stat[2]);
 
-        sort(files.begin(), files.end());
+        NodeBatch batch;
+        for (const char *file : files)
+            batch.add(dir, file);
+        batch.read();
 
-        for (auto &file : files) {
-            std::string fileLocation = std::string(stat[1]) + file;
-            if (!android::base::ReadFileToString(fileLocation, &content)) {
+        for (size_t i = 0; i < files.size(); i++) {
+            if (!batch.get(i, &content)) {
                 content = "\n";
             }
 
-            printf("%s: %s", file.c_str(), content.c_str());
+            dumpPrintf("%s: %s", files[i], content.c_str());
+            dumpRecordValue(std::string(stat[0]) + "." + files[i], android::base::Trim(content),
+                    batch.path(i));
 
             if (content.back() != '\n')
-                printf("\n");
+                dumpPrintf("\n");
         }
-        files.clear();
     }
 }
 
@@ -604,29 +619,97 @@ void dumpGvoteables() {
     const char *statusName = "/status";
     const char *title = "gvotables";
     std::string content;
-    std::vector<std::string> files;
-    int ret;
 
     if (isUserBuild())
         return;
 
-    ret = getFilesInDir(directory, &files);
-    if (ret < 0)
+    NodeDir dir(directory);
+    if (!dir.ok())
         return;
 
     printTitle(title);
-    for (auto &file : files) {
-        std::string fileLocation = std::string(directory) + file + std::string(statusName);
-        if (!android::base::ReadFileToString(fileLocation, &content)) {
+    const std::vector<const char *> &files = dir.list();
+
+    NodeBatch batch;
+    for (const char *file : files)
+        batch.add(dir, (std::string(file) + statusName).c_str());
+    batch.read();
+
+    for (size_t i = 0; i < files.size(); i++) {
+        if (!batch.get(i, &content)) {
             continue;
         }
 
-        printf("%s: %s", file.c_str(), content.c_str());
+        dumpPrintf("%s: %s", files[i], content.c_str());
 
         if (content.back() != '\n')
-            printf("\n");
+            dumpPrintf("\n");
+    }
+}
+
+/*
+ * thismeal.bin is decoded into thismeal.txt by battery_mitigation, which owns the binary record
+ * layout. The record is decoded on every dump, so a failed decode is reported rather than left
+ * behind an older thismeal.txt, and is bounded in size and time so a stuck helper can't hold up
+ * the rest of the dump.
+ */
+void decodeThismeal() {
+    const char *thismealBin = "/data/vendor/mitigation/thismeal.bin";
+    const off_t maxThismealSize = 1024 * 1024;
+    const int decodeTimeoutMs = 2000;
+    const int pollIntervalMs = 5;
+    const char *helper = "/vendor/bin/hw/battery_mitigation";
+    char *const argv[] = {const_cast<char *>("battery_mitigation"), const_cast<char *>("-d"),
+                          nullptr};
+    struct stat binStat;
+    posix_spawn_file_actions_t actions;
+    pid_t pid;
+    int status;
+    int ret;
+
+    if (stat(thismealBin, &binStat) != 0)
+        return;
+
+    if (binStat.st_size > maxThismealSize) {
+        dumpPrintf("Skip parsing thismeal.bin.(size %lld exceeds %lld)\n",
+                static_cast<long long>(binStat.st_size), static_cast<long long>(maxThismealSize));
+        return;
+    }
+
+    /*
+     * Sections run on worker threads, so the helper is spawned rather than forked. Section output
+     * is buffered, so anything the helper printed would land out of place.
+     */
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    ret = posix_spawn(&pid, helper, &actions, nullptr, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (ret != 0) {
+        dumpPrintf("Spawn failed for parsing thismeal.bin.(%s)\n", strerror(ret));
+        return;
+    }
+
+    for (int waitedMs = 0;; waitedMs += pollIntervalMs) {
+        ret = TEMP_FAILURE_RETRY(waitpid(pid, &status, WNOHANG));
+        if (ret == pid)
+            break;
+        if (ret < 0)
+            return;
+        if (waitedMs >= decodeTimeoutMs) {
+            kill(pid, SIGKILL);
+            TEMP_FAILURE_RETRY(waitpid(pid, &status, 0));
+            dumpPrintf("Failed to parse thismeal.bin.(timed out after %d ms)\n", decodeTimeoutMs);
+            return;
+        }
+        usleep(pollIntervalMs * 1000);
+    }
+
+    if (WIFSIGNALED(status)) {
+        dumpPrintf("Failed to parse thismeal.bin.(killed by: %d)\n", WTERMSIG(status));
+    } else if (WEXITSTATUS(status) != 0) {
+        dumpPrintf("Failed to parse thismeal.bin.(exit status: %d)\n", WEXITSTATUS(status));
     }
-    files.clear();
 }
 
 void dumpMitigation() {
@@ -636,21 +719,7 @@ void dumpMitigation() {
             {"Thismeal" , "/data/vendor/mitigation/thismeal.txt"},
     };
 
-    /* parsing thismeal.bin */
-    int status;
-    int pid = fork();
-    if (pid < 0) {
-        printf("Fork failed for parsing thismeal.bin.\n");
-        exit(EXIT_FAILURE);
-    } else if (pid == 0) {
-        execl("/vendor/bin/hw/battery_mitigation", "battery_mitigation", "-d", nullptr);
-        exit(EXIT_SUCCESS);
-    }
-    waitpid(pid, &status, 0);
-
-    if (WIFSIGNALED(status)) {
-        printf("Failed to parse thismeal.bin.(killed by: %d)\n", WTERMSIG(status));
-    }
+    decodeThismeal();
 
     for (auto &row : mitigationList) {
         if (!isValidFile(row[1]))
@@ -660,7 +729,6 @@ void dumpMitigation() {
 }
 
 void dumpMitigationStats() {
-    int ret;
     const char *directory = "/sys/devices/virtual/pmic/mitigation/last_triggered_count/";
     const char *capacityDirectory = "/sys/devices/virtual/pmic/mitigation/last_triggered_capacity/";
     const char *timestampDirectory =
@@ -672,67 +740,54 @@ void dumpMitigationStats() {
     const char *countSuffix = "_count";
     const char *title = "Mitigation Stats";
 
-    std::vector<std::string> files;
     std::string content;
-    std::string fileLocation;
-    std::string source;
     std::string subModuleName;
-    int count;
-    int soc;
-    int time;
-    int voltage;
 
-    ret = getFilesInDir(directory, &files);
-    if (ret < 0)
+    NodeDir countDir(directory);
+    if (!countDir.ok())
         return;
+    NodeDir capacityDir(capacityDirectory);
+    NodeDir timestampDir(timestampDirectory);
+    NodeDir voltageDir(voltageDirectory);
 
     printTitle(title);
-    printf("Source\t\tCount\tSOC\tTime\tVoltage\n");
-
-    for (auto &file : files) {
-        fileLocation = std::string(directory) + std::string(file);
-        if (!android::base::ReadFileToString(fileLocation, &content)) {
-            continue;
-        }
+    dumpPrintf("Source\t\tCount\tSOC\tTime\tVoltage\n");
 
-        ret = atoi(android::base::Trim(content).c_str());
-        if (ret == -1)
-            continue;
-        count = ret;
-
-        subModuleName = std::string(file);
+    /* The count, capacity, timestamp and voltage nodes of every source, in one batch. */
+    std::vector<std::string> subModuleNames;
+    NodeBatch batch;
+    for (const char *file : countDir.list(NodeDir::SUBSTRING, countSuffix)) {
+        subModuleName = file;
         subModuleName.erase(subModuleName.find(countSuffix), strlen(countSuffix));
+        subModuleNames.push_back(subModuleName);
+        batch.add(countDir, file);
+        batch.add(capacityDir, (subModuleName + capacitySuffix).c_str());
+        batch.add(timestampDir, (subModuleName + timeSuffix).c_str());
+        batch.add(voltageDir, (subModuleName + voltageSuffix).c_str());
+    }
+    batch.read();
 
-        fileLocation = std::string(capacityDirectory) + std::string(subModuleName) +
-                std::string(capacitySuffix);
-        if (!android::base::ReadFileToString(fileLocation, &content)) {
-            continue;
-        }
-        ret = atoi(android::base::Trim(content).c_str());
-        if (ret == -1)
-            continue;
-        soc = ret;
+    for (size_t i = 0; i < subModuleNames.size(); i++) {
+        const size_t node = i * 4;
 
-        fileLocation = std::string(timestampDirectory) + std::string(subModuleName) +
-                std::string(timeSuffix);
-        if (!android::base::ReadFileToString(fileLocation, &content)) {
-            continue;
+        /* Count, SOC, time and voltage; a source is left out if any of them is unset (-1). */
+        int64_t values[4];
+        bool valid = true;
+        for (size_t field = 0; field < 4 && valid; field++) {
+            valid = batch.get(node + field, &content) && parseInt(content, &values[field]) &&
+                    values[field] != -1;
         }
-        ret = atoi(android::base::Trim(content).c_str());
-        if (ret == -1)
+        if (!valid)
             continue;
-        time = ret;
 
-        fileLocation = std::string(voltageDirectory) + std::string(subModuleName) +
-                std::string(voltageSuffix);
-        if (!android::base::ReadFileToString(fileLocation, &content)) {
-            continue;
-        }
-        ret = atoi(android::base::Trim(content).c_str());
-        if (ret == -1)
-            continue;
-        voltage = ret;
-        printf("%s \t%i\t%i\t%i\t%i\n", subModuleName.c_str(), count, soc, time, voltage);
+        subModuleName = subModuleNames[i];
+        dumpPrintf("%s \t%" PRId64 "\t%" PRId64 "\t%" PRId64 "\t%" PRId64 "\n", subModuleName.c_str(),
+                values[0], values[1], values[2], values[3]);
+
+        dumpRecord(subModuleName + ".count", values[0], batch.path(node));
+        dumpRecord(subModuleName + ".soc", values[1], batch.path(node + 1));
+        dumpRecord(subModuleName + ".time", values[2], batch.path(node + 2));
+        dumpRecord(subModuleName + ".voltage", values[3], batch.path(node + 3));
     }
 }
 
@@ -760,41 +815,64 @@ void dumpMitigationDirs() {
     const int eraseCnt[] = {6, 6, 4, 0};
     const bool useTitleRow[] = {true, true, true, false};
 
-    std::vector<std::string> files;
+    std::vector<NodeDir> dirs;
+    std::vector<const char *> files[paramCount];
     std::string content;
-    std::string fileLocation;
-    std::string source;
-    std::string subModuleName;
-    std::string readout;
 
+    /* Every node of the four directories is read in one batch. */
+    NodeBatch batch;
+    dirs.reserve(paramCount);
+    for (int i = 0; i < paramCount; i++) {
+        dirs.emplace_back(directories[i]);
+        files[i] = dirs[i].list();
+        for (const char *file : files[i])
+            batch.add(dirs[i], file);
+    }
+    batch.read();
+
+    size_t node = 0;
     for (int i = 0; i < paramCount; i++) {
         printTitle(titles[i]);
         if (useTitleRow[i]) {
-            printf("%s\n", titleRowVal[i]);
+            dumpPrintf("%s\n", titleRowVal[i]);
         }
 
-        getFilesInDir(directories[i], &files);
-
-        for (auto &file : files) {
-            fileLocation = std::string(directories[i]) + std::string(file);
-            if (!android::base::ReadFileToString(fileLocation, &content)) {
+        for (const char *file : files[i]) {
+            const size_t index = node++;
+            if (!batch.get(index, &content)) {
                 continue;
             }
 
-            readout = android::base::Trim(content);
-
-            subModuleName = std::string(file);
-            subModuleName.erase(subModuleName.find(paramSuffix[i]), eraseCnt[i]);
-
-            if (useTitleRow[i]) {
-                printf("%s \t%s\n", subModuleName.c_str(), readout.c_str());
-            } else {
-                printf("%s=%s\n", subModuleName.c_str(), readout.c_str());
+            const std::string_view readout = trimmed(content);
+
+            /* The source name is the file name without its parameter suffix. */
+            const std::string_view name(file);
+            const size_t suffix = std::min(name.find(paramSuffix[i]), name.size());
+            const std::string_view head = name.substr(0, suffix);
+            const std::string_view tail = name.substr(std::min(suffix + eraseCnt[i], name.size()));
+
+            dumpPrintf(useTitleRow[i] ? "%.*s%.*s \t%.*s\n" : "%.*s%.*s=%.*s\n",
+                    static_cast<int>(head.size()), head.data(),
+                    static_cast<int>(tail.size()), tail.data(),
+                    static_cast<int>(readout.size()), readout.data());
+            if (structuredOutput()) {
+                dumpRecordValue(std::string(titles[i]) + "." + std::string(head) +
+                        std::string(tail), std::string(readout), batch.path(index));
             }
         }
     }
 }
 
+/* A table cell as a typed record when it holds a number, as text otherwise. */
+void recordColumn(const std::string &key, std::string_view text, const std::string &path) {
+    int64_t value;
+
+    if (parseInt(text, &value))
+        dumpRecord(key, value, path);
+    else
+        dumpRecordValue(key, std::string(trimmed(text)), path);
+}
+
 void dumpIrqDurationCounts() {
     const char *title = "IRQ Duration Counts";
     const char *colNames = "Source\t\t\t\tlt_5ms_cnt\tbt_5ms_to_10ms_cnt\tgt_10ms_cnt\tCode"
@@ -831,129 +909,120 @@ void dumpIrqDurationCounts() {
                     "s2mpg15-odpm/iio:device0/lpf_current",
     };
 
-    bool titlesInitialized = false;
-
-    std::vector<std::string> channelNames;
-    std::vector<std::string> channelData[DUR_MAX];
-    std::vector<std::string> pwrwarnThreshold[PWRWARN_MAX];
-    std::vector<std::string> pwrwarnCode[PWRWARN_MAX];
-    std::vector<std::string> lpfCurrentVals[PWRWARN_MAX];
-    std::vector<std::string> files;
-
-    std::string content;
-    std::string token;
-    std::string tokenCh;
-    std::string fileLocation;
+    /* Each column is decoded as typed numbers and views into the node contents. */
+    std::string durationContent[DUR_MAX];
+    std::vector<TableRow> durationRows[DUR_MAX];
+    std::vector<std::string> pwrwarnContent[PWRWARN_MAX];
+    std::vector<std::string> pwrwarnPaths[PWRWARN_MAX];
+    std::string lpfCurrentContent[PWRWARN_MAX];
+    std::vector<std::string_view> lpfCurrentVals[PWRWARN_MAX];
 
     for (int i = 0; i < DUR_MAX; i++) {
-        if (!android::base::ReadFileToString(irqDurDirectories[i], &content)) {
+        if (!readNodeToString(irqDurDirectories[i], &durationContent[i])) {
             return;
         }
-
-        std::istringstream tokenStream(content);
-
-        while (std::getline(tokenStream, token, '\n')) {
-            if (!titlesInitialized) {
-                tokenCh = token;
-                tokenCh.erase(tokenCh.find(':'), tokenCh.length());
-                channelNames.push_back(tokenCh);
-            }
-
-            // there is a space after the ':' which needs to be removed
-            token.erase(0, token.find(':') + 1);
-            channelData[i].push_back(token);
-
-        }
-        if (!titlesInitialized)
-            titlesInitialized = true;
+        // there is a space after the ':' which stays in the text of each row
+        parseTable(durationContent[i], ':', &durationRows[i]);
     }
+    const std::vector<TableRow> &channels = durationRows[LT_5MS];
 
     for (int i = 0; i < PWRWARN_MAX; i++) {
-        getFilesInDir(pwrwarnDirectories[i], &files);
+        NodeDir dir(pwrwarnDirectories[i]);
+        std::string content;
 
-        for (auto &file : files) {
-            fileLocation = std::string(pwrwarnDirectories[i]) + std::string(file);
-            if (!android::base::ReadFileToString(fileLocation, &content)) {
+        for (const char *file : dir.list()) {
+            if (!readNodeToString(dir, file, &content)) {
                 continue;
             }
-
-            std::string readout;
-
-            readout = android::base::Trim(content);
-
-            std::string readoutThreshold = readout;
-            readoutThreshold.erase(0, readoutThreshold.find('=') + 1);
-
-            std::string readoutCode = readout;
-            readoutCode.erase(readoutCode.find('='), readoutCode.length());
-
-            pwrwarnThreshold[i].push_back(readoutThreshold);
-            pwrwarnCode[i].push_back(readoutCode);
+            pwrwarnContent[i].push_back(std::move(content));
+            pwrwarnPaths[i].push_back(dir.pathOf(file));
         }
     }
 
     for (int i = 0; i < PWRWARN_MAX; i++) {
-        if (!android::base::ReadFileToString(lpfCurrentDirs[i], &content)) {
+        if (!readNodeToString(lpfCurrentDirs[i], &lpfCurrentContent[i])) {
             continue;
         }
 
-        std::istringstream tokenStream(content);
-
+        LineReader lines(lpfCurrentContent[i]);
+        std::string_view line;
         bool first = true;
-        while (std::getline(tokenStream, token, '\n')) {
-            token.erase(0, token.find(' '));
+        while (lines.next(&line)) {
             if (first) {
                 first = false;
                 continue;
             }
-            lpfCurrentVals[i].push_back(token);
+            const size_t space = line.find(' ');
+            lpfCurrentVals[i].push_back(space == std::string_view::npos ? std::string_view()
+                                                                        : line.substr(space));
         }
     }
 
     printTitle(title);
-    printf("%s", colNames);
-
-    for (uint i = 0; i < channelNames.size(); i++) {
-        std::string code = "";
-        std::string threshold = "";
-        std::string current = "";
-        std::string ltDataMsg = "";
-        std::string btDataMsg = "";
-        std::string gtDataMsg = "";
-        int pmicSel = 0;
-        int offset = 0;
-        std::string channelNameSuffix = "      \t";
+    dumpPrintf("%s", colNames);
+
+    for (size_t i = 0; i < channels.size(); i++) {
+        std::string_view code;
+        std::string_view threshold;
+        std::string_view current;
+        std::string_view data[DUR_MAX];
+        const char *channelNameSuffix = "      \t";
+        int pmicSel = -1;
+        size_t index = 0;
+
         if (i >= nonOdpmChannelCnt) {
-            offset = nonOdpmChannelCnt;
+            pmicSel = MAIN;
+            index = i - nonOdpmChannelCnt;
             if (i >= (odpmChCnt + nonOdpmChannelCnt)) {
-                pmicSel = 1;
-                offset = odpmChCnt + nonOdpmChannelCnt;
+                pmicSel = SUB;
+                index = i - (odpmChCnt + nonOdpmChannelCnt);
             }
             channelNameSuffix = "";
 
-            code = pwrwarnCode[pmicSel][i - offset];
-            threshold = pwrwarnThreshold[pmicSel][i - offset];
-            current = lpfCurrentVals[pmicSel][i - offset];
+            /* A "code=threshold" node; nodes without '=' give their whole readout to both. */
+            if (index < pwrwarnContent[pmicSel].size()) {
+                const std::string_view readout = trimmed(pwrwarnContent[pmicSel][index]);
+                const size_t equals = readout.find('=');
+                code = readout.substr(0, equals);
+                threshold = equals == std::string_view::npos ? readout : readout.substr(equals + 1);
+            }
+            if (index < lpfCurrentVals[pmicSel].size())
+                current = lpfCurrentVals[pmicSel][index];
         }
 
-        if (i < channelData[0].size())
-            ltDataMsg = channelData[0][i];
-
-        if (i < channelData[1].size())
-            btDataMsg = channelData[1][i];
-
-        if (i < channelData[2].size())
-            gtDataMsg = channelData[2][i];
+        for (int d = 0; d < DUR_MAX; d++) {
+            if (i < durationRows[d].size())
+                data[d] = durationRows[d][i].text;
+        }
 
-        std::string adjustedChannelName = channelNames[i] + channelNameSuffix;
-        printf("%s     \t%s\t\t%s\t\t\t%s\t\t%s    \t%s       \t\t%s\n",
-                adjustedChannelName.c_str(),
-                ltDataMsg.c_str(),
-                btDataMsg.c_str(),
-                gtDataMsg.c_str(),
-                code.c_str(),
-                threshold.c_str(),
-                current.c_str());
+        dumpPrintf("%.*s%s     \t%.*s\t\t%.*s\t\t\t%.*s\t\t%.*s    \t%.*s       \t\t%.*s\n",
+                static_cast<int>(channels[i].name.size()), channels[i].name.data(),
+                channelNameSuffix,
+                static_cast<int>(data[LT_5MS].size()), data[LT_5MS].data(),
+                static_cast<int>(data[BT_5MS_10MS].size()), data[BT_5MS_10MS].data(),
+                static_cast<int>(data[GT_10MS].size()), data[GT_10MS].data(),
+                static_cast<int>(code.size()), code.data(),
+                static_cast<int>(threshold.size()), threshold.data(),
+                static_cast<int>(current.size()), current.data());
+
+        if (structuredOutput()) {
+            const std::string channel = std::string(trimmed(channels[i].name)) + ".";
+            const char *durationKeys[] = {"lt_5ms_cnt", "bt_5ms_to_10ms_cnt", "gt_10ms_cnt"};
+            for (int d = 0; d < DUR_MAX; d++) {
+                if (i < durationRows[d].size() && durationRows[d][i].numeric)
+                    dumpRecord(channel + durationKeys[d], durationRows[d][i].value,
+                            irqDurDirectories[d]);
+                else
+                    recordColumn(channel + durationKeys[d], data[d], irqDurDirectories[d]);
+            }
+            if (pmicSel >= 0) {
+                const std::string pwrwarnPath = index < pwrwarnPaths[pmicSel].size()
+                        ? pwrwarnPaths[pmicSel][index] : std::string(pwrwarnDirectories[pmicSel]);
+                recordColumn(channel + "code", code, pwrwarnPath);
+                recordColumn(channel + "current_threshold_ua", threshold, pwrwarnPath);
+                recordColumn(channel + "current_reading_ua", current, lpfCurrentDirs[pmicSel]);
+            }
+        }
     }
 }
 
@@ -964,34 +1033,35 @@ void dumpCpuIdleHistogramStats() {
     const char* cpuClusterHistogramTitle = "CPU Cluster Histogram";
     const char* cpuClusterHistogramFile = "/sys/kernel/metrics/"
                                     "cpuidle_histogram/cpucluster_histogram";
-    dumpFileContent(cpuIdleHistogramTitle, cpuIdleHistogramFile);
-    dumpFileContent(cpuClusterHistogramTitle, cpuClusterHistogramFile);
-}
-
-int main() {
-    dumpPowerStatsTimes();
-    dumpAcpmStats();
-    dumpCpuIdleHistogramStats();
-    dumpPowerSupplyStats();
-    dumpMaxFg();
-    dumpPowerSupplyDock();
-    dumpLogBufferTcpm();
-    dumpTcpc();
-    dumpPdEngine();
-    dumpEusbRepeater();
-    dumpWc68();
-    dumpLn8411();
-    dumpBatteryHealth();
-    dumpBatteryDefend();
-    dumpChg();
-    dumpChgUserDebug();
-    dumpBatteryEeprom();
-    dumpChargerStats();
-    dumpWlcLogs();
-    dumpGvoteables();
-    dumpMitigation();
-    dumpMitigationStats();
-    dumpMitigationDirs();
-    dumpIrqDurationCounts();
+    dumpCpuidleHistogram(cpuIdleHistogramTitle, cpuIdleHistogramFile);
+    dumpCpuidleHistogram(cpuClusterHistogramTitle, cpuClusterHistogramFile);
 }
 
+const DumpSection dumpSections[] = {
+        {"times", dumpPowerStatsTimes},
+        {"acpm", dumpAcpmStats},
+        {"cpuidle", dumpCpuIdleHistogramStats},
+        {"power_supply", dumpPowerSupplyStats, PRIORITY_HIGH},
+        {"maxfg", dumpMaxFg},
+        {"dock", dumpPowerSupplyDock},
+        {"tcpm", dumpLogBufferTcpm},
+        {"tcpc", dumpTcpc},
+        {"pd_engine", dumpPdEngine},
+        {"eusb_repeater", dumpEusbRepeater},
+        {"wc68", dumpWc68},
+        {"ln8411", dumpLn8411},
+        {"battery_health", dumpBatteryHealth},
+        {"battery_defend", dumpBatteryDefend},
+        {"chg", dumpChg},
+        {"chg_user_debug", dumpChgUserDebug, PRIORITY_OPTIONAL},
+        {"battery_eeprom", dumpBatteryEeprom},
+        {"charger_stats", dumpChargerStats},
+        {"wlc", dumpWlcLogs},
+        {"gvotables", dumpGvoteables, PRIORITY_OPTIONAL},
+        {"mitigation", dumpMitigation},
+        {"mitigation_stats", dumpMitigationStats, PRIORITY_HIGH},
+        {"mitigation_dirs", dumpMitigationDirs},
+        {"irq_duration", dumpIrqDurationCounts},
+        {"history", dumpHistory},
+};
+const size_t dumpSectionCount = sizeof(dumpSections) / sizeof(dumpSections[0]);
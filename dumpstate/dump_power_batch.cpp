@@ -0,0 +1,700 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_batch.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <android-base/unique_fd.h>
+
+#include "dump_power_io.h"
+#include "dump_power_nodecache.h"
+#include "dump_power_pack.h"
+#include "dump_power_profile.h"
+
+using std::chrono::steady_clock;
+
+struct BatchState {
+    struct Node {
+        // Index into dirFds, or -1 for a node added by its full path.
+        int dir;
+        // Offset of the name or path in names.
+        size_t name;
+    };
+
+    std::vector<Node> nodes;
+    std::string names;
+    // Duplicates of the NodeDir descriptors, open as long as requests may use them.
+    std::vector<android::base::unique_fd> dirFds;
+    std::vector<std::string> dirPrefixes;
+    // The NodeDir each descriptor was duplicated from.
+    std::vector<const NodeDir *> dirs;
+    // Bytes read, or -errno.
+    std::vector<ssize_t> results;
+    std::vector<char> opened;
+    std::vector<char> done;
+    // CLOCK_BOOTTIME around the read of each node, 0 if it wasn't read.
+    std::vector<int64_t> readStartNs;
+    std::vector<int64_t> readEndNs;
+    std::unique_ptr<char[]> buffers;
+    // Whole contents of the nodes that didn't fit their buffer, set in inLarge.
+    std::vector<std::string> large;
+    std::vector<char> inLarge;
+
+    // Thread pool fallback.
+    std::mutex lock;
+    std::condition_variable cv;
+    size_t next = 0;
+    size_t completed = 0;
+    bool abandoned = false;
+    // No worker starts another node of the batch once this passed.
+    steady_clock::time_point deadline = steady_clock::time_point::max();
+
+    char *buffer(size_t index) { return &buffers[index * NodeBatch::nodeBufferSize]; }
+    /*
+     * Where the next read of node |index|, which has |used| bytes so far, goes
+     * and how much it may read: the node buffer, and once that is full, the
+     * end of its large content. readDone() ends the read.
+     */
+    char *readTarget(size_t index, size_t used, size_t *len) {
+        if (used < NodeBatch::nodeBufferSize) {
+            *len = NodeBatch::nodeBufferSize - used;
+            return buffer(index) + used;
+        }
+        if (!inLarge[index]) {
+            large[index].assign(buffer(index), used);
+            inLarge[index] = true;
+        }
+        large[index].resize(used + NodeBatch::nodeBufferSize);
+        *len = NodeBatch::nodeBufferSize;
+        return &large[index][used];
+    }
+    void readDone(size_t index, size_t used) {
+        if (inLarge[index])
+            large[index].resize(used);
+    }
+    int dirFd(size_t index) const {
+        return nodes[index].dir < 0 ? AT_FDCWD : dirFds[nodes[index].dir].get();
+    }
+    const char *name(size_t index) const { return &names[nodes[index].name]; }
+    // Directory descriptor and name to open node |index| with, below the node root.
+    const char *openName(size_t index, int *fd) const {
+        *fd = dirFd(index);
+        return rootedNodePath(fd, name(index));
+    }
+    std::string path(size_t index) const {
+        if (nodes[index].dir < 0)
+            return name(index);
+        return dirPrefixes[nodes[index].dir] + name(index);
+    }
+};
+
+namespace {
+
+constexpr unsigned ringEntries = 64;
+constexpr size_t poolThreads = 4;
+// Bounds the workers started in place of ones stuck in a node.
+constexpr size_t maxPoolThreads = 16;
+
+int64_t boottimeNs() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * A minimal io_uring, driven through the raw system calls. All requests of
+ * a phase are queued, submitted with one io_uring_enter() and reaped before
+ * the next phase starts.
+ */
+class Ring {
+  public:
+    ~Ring();
+
+    bool init();
+    io_uring_sqe *queue();
+    /*
+     * Submits the queued requests and hands every completion to |complete|.
+     * Returns false if |deadline| passed first, or the ring failed.
+     */
+    template <typename Complete>
+    bool run(steady_clock::time_point deadline, Complete complete);
+
+  private:
+    int enter(unsigned submit, unsigned wait, steady_clock::time_point deadline);
+
+    int mFd = -1;
+    void *mSqRing = MAP_FAILED;
+    void *mCqRing = MAP_FAILED;
+    size_t mSqRingSize = 0;
+    size_t mCqRingSize = 0;
+    io_uring_sqe *mSqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+    size_t mSqesSize = 0;
+
+    unsigned *mSqTail = nullptr;
+    unsigned mSqMask = 0;
+    unsigned *mCqHead = nullptr;
+    unsigned *mCqTail = nullptr;
+    unsigned mCqMask = 0;
+    io_uring_cqe *mCqes = nullptr;
+    unsigned mQueued = 0;
+};
+
+Ring::~Ring() {
+    if (mSqes != MAP_FAILED)
+        munmap(mSqes, mSqesSize);
+    if (mCqRing != MAP_FAILED && mCqRing != mSqRing)
+        munmap(mCqRing, mCqRingSize);
+    if (mSqRing != MAP_FAILED)
+        munmap(mSqRing, mSqRingSize);
+    if (mFd >= 0)
+        close(mFd);
+}
+
+bool Ring::init() {
+    io_uring_params params = {};
+
+    mFd = syscall(__NR_io_uring_setup, ringEntries, &params);
+    if (mFd < 0)
+        return false;
+    /* Waiting against a deadline needs IORING_ENTER_EXT_ARG, which also implies the ops used. */
+    if (!(params.features & IORING_FEAT_EXT_ARG))
+        return false;
+
+    mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        mSqRingSize = mCqRingSize = std::max(mSqRingSize, mCqRingSize);
+
+    mSqRing = mmap(nullptr, mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mFd,
+                   IORING_OFF_SQ_RING);
+    if (mSqRing == MAP_FAILED)
+        return false;
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        mCqRing = mSqRing;
+    } else {
+        mCqRing = mmap(nullptr, mCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       mFd, IORING_OFF_CQ_RING);
+        if (mCqRing == MAP_FAILED)
+            return false;
+    }
+    mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    mSqes = static_cast<io_uring_sqe *>(mmap(nullptr, mSqesSize, PROT_READ | PROT_WRITE,
+                                             MAP_SHARED | MAP_POPULATE, mFd, IORING_OFF_SQES));
+    if (mSqes == MAP_FAILED)
+        return false;
+
+    char *sq = static_cast<char *>(mSqRing);
+    char *cq = static_cast<char *>(mCqRing);
+    mSqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    mSqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    mCqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    mCqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    mCqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    mCqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    /* Slot i of the submission array always points at sqe i. */
+    unsigned *array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    for (unsigned i = 0; i < params.sq_entries; i++)
+        array[i] = i;
+    return true;
+}
+
+io_uring_sqe *Ring::queue() {
+    io_uring_sqe *sqe = &mSqes[(*mSqTail + mQueued) & mSqMask];
+
+    memset(sqe, 0, sizeof(*sqe));
+    mQueued++;
+    return sqe;
+}
+
+int Ring::enter(unsigned submit, unsigned wait, steady_clock::time_point deadline) {
+    if (deadline == steady_clock::time_point::max())
+        return syscall(__NR_io_uring_enter, mFd, submit, wait, IORING_ENTER_GETEVENTS, nullptr, 0);
+
+    auto left = std::max(deadline - steady_clock::now(), steady_clock::duration::zero());
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(left).count();
+    __kernel_timespec ts = {ns / 1000000000, ns % 1000000000};
+    io_uring_getevents_arg arg = {};
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = reinterpret_cast<uintptr_t>(&ts);
+
+    return syscall(__NR_io_uring_enter, mFd, submit, wait,
+                   IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+}
+
+template <typename Complete>
+bool Ring::run(steady_clock::time_point deadline, Complete complete) {
+    const unsigned expected = mQueued;
+    unsigned submit = mQueued;
+    unsigned reaped = 0;
+
+    __atomic_store_n(mSqTail, *mSqTail + mQueued, __ATOMIC_RELEASE);
+    mQueued = 0;
+
+    while (reaped < expected) {
+        unsigned head = *mCqHead;
+        unsigned tail = __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+
+        for (; head != tail; head++, reaped++) {
+            const io_uring_cqe &cqe = mCqes[head & mCqMask];
+            complete(cqe.user_data, cqe.res);
+        }
+        __atomic_store_n(mCqHead, head, __ATOMIC_RELEASE);
+        if (reaped == expected)
+            break;
+
+        int ret = enter(submit, 1, deadline);
+        if (ret >= 0)
+            submit -= std::min<unsigned>(ret, submit);
+        else if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            return false;
+    }
+    return true;
+}
+
+std::atomic<bool> gRingUnavailable(false);
+thread_local std::unique_ptr<Ring> tRing;
+
+/* The ring of the calling thread, or null where io_uring can't or mustn't be used. */
+Ring *threadRing() {
+    if (gRingUnavailable)
+        return nullptr;
+    if (tRing)
+        return tRing.get();
+
+    std::unique_ptr<Ring> ring = std::make_unique<Ring>();
+    if (!ring->init()) {
+        gRingUnavailable = true;
+        return nullptr;
+    }
+    tRing = std::move(ring);
+    return tRing.get();
+}
+
+/*
+ * Reads the batch through |ring|, at most ringEntries nodes per round of
+ * open, read and close submissions. Returns false if the deadline passed,
+ * in which case requests are still in flight in the ring.
+ */
+bool readWithRing(Ring *ring, BatchState *state, steady_clock::time_point deadline) {
+    const size_t count = state->nodes.size();
+
+    for (size_t begin = 0; begin < count; begin += ringEntries) {
+        const size_t end = std::min(count, begin + ringEntries);
+        std::vector<int> fds(end - begin, -1);
+        bool ok;
+
+        for (size_t i = begin; i < end; i++) {
+            io_uring_sqe *sqe = ring->queue();
+            sqe->opcode = IORING_OP_OPENAT;
+            int dirFd;
+            sqe->addr = reinterpret_cast<uintptr_t>(state->openName(i, &dirFd));
+            sqe->fd = dirFd;
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            sqe->user_data = i;
+        }
+        ok = ring->run(deadline, [&](uint64_t i, int res) {
+            if (res >= 0) {
+                fds[i - begin] = res;
+                state->opened[i] = true;
+            } else {
+                state->results[i] = res;
+                state->done[i] = true;
+            }
+        });
+        if (!ok)
+            return false;
+
+        /*
+         * Every node is read to its end: seq_file nodes return short reads long
+         * before that. Each round reads the nodes that returned data in the last
+         * one, from the file position, and a node's read ends when its EOF is reaped.
+         */
+        std::vector<size_t> reading;
+        for (size_t i = begin; i < end; i++) {
+            if (fds[i - begin] >= 0) {
+                reading.push_back(i);
+                state->results[i] = 0;
+            }
+        }
+        const int64_t startNs = boottimeNs();
+        for (size_t i : reading)
+            state->readStartNs[i] = startNs;
+        while (!reading.empty()) {
+            for (size_t i : reading) {
+                size_t len;
+                char *target = state->readTarget(i, state->results[i], &len);
+                io_uring_sqe *sqe = ring->queue();
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = fds[i - begin];
+                sqe->addr = reinterpret_cast<uintptr_t>(target);
+                sqe->len = len;
+                sqe->off = static_cast<uint64_t>(-1);
+                sqe->user_data = i;
+            }
+            std::vector<size_t> again;
+            ok = ring->run(deadline, [&](uint64_t i, int res) {
+                if (res > 0) {
+                    state->results[i] += res;
+                    again.push_back(i);
+                } else {
+                    if (res < 0)
+                        state->results[i] = res;
+                    state->done[i] = true;
+                    state->readEndNs[i] = boottimeNs();
+                }
+                state->readDone(i, std::max<ssize_t>(state->results[i], 0));
+            });
+            if (!ok)
+                return false;
+            reading.swap(again);
+        }
+
+        for (int fd : fds) {
+            if (fd < 0)
+                continue;
+            io_uring_sqe *sqe = ring->queue();
+            sqe->opcode = IORING_OP_CLOSE;
+            sqe->fd = fd;
+        }
+        ring->run(steady_clock::time_point::max(), [](uint64_t, int) {});
+    }
+    return true;
+}
+
+/* Reads node |index| from |fd| to its end. Returns its size, or -errno. */
+ssize_t readToEnd(BatchState *state, size_t index, int fd) {
+    size_t used = 0;
+
+    while (true) {
+        size_t len;
+        char *target = state->readTarget(index, used, &len);
+        ssize_t ret = TEMP_FAILURE_RETRY(read(fd, target, len));
+        int error = errno;
+
+        used += std::max<ssize_t>(ret, 0);
+        state->readDone(index, used);
+        if (ret <= 0)
+            return ret < 0 ? -error : used;
+    }
+}
+
+/*
+ * Reads the next node of |state| that no worker took yet. Returns false if
+ * there was none left, or the batch was abandoned or is past its deadline.
+ */
+bool readNextNode(BatchState *state) {
+    std::unique_lock<std::mutex> lock(state->lock);
+
+    if (state->abandoned || state->next >= state->nodes.size() ||
+        steady_clock::now() >= state->deadline)
+        return false;
+    const size_t i = state->next++;
+    lock.unlock();
+
+    ssize_t result;
+    int64_t startNs = 0;
+    int64_t endNs = 0;
+    int dirFd;
+    const char *name = state->openName(i, &dirFd);
+    int fd = TEMP_FAILURE_RETRY(openat(dirFd, name, O_RDONLY | O_CLOEXEC));
+    if (fd < 0) {
+        result = -errno;
+    } else {
+        startNs = boottimeNs();
+        result = readToEnd(state, i, fd);
+        endNs = boottimeNs();
+        close(fd);
+    }
+
+    lock.lock();
+    /* Once abandoned, the caller has reported what is left as TIMEOUT. */
+    if (state->abandoned)
+        return false;
+    state->results[i] = result;
+    state->readStartNs[i] = startNs;
+    state->readEndNs[i] = endNs;
+    state->opened[i] = fd >= 0;
+    state->done[i] = true;
+    state->completed++;
+    state->cv.notify_all();
+    return true;
+}
+
+/*
+ * The thread pool fallback: poolThreads workers, started once per process,
+ * that work through the submitted batches in order. A batch that misses its
+ * deadline leaves its workers stuck in their nodes, so as many workers are
+ * started in their place, up to maxPoolThreads in all; once the stuck ones
+ * return, the pool shrinks back to poolThreads as workers go idle.
+ */
+class BatchPool {
+  public:
+    void submit(const std::shared_ptr<BatchState> &state);
+    // Starts workers in place of |stuck| ones that are still reading a node.
+    void replace(size_t stuck);
+
+  private:
+    void startWorkers(size_t count);
+    void worker();
+
+    std::mutex mLock;
+    std::condition_variable mCv;
+    std::deque<std::shared_ptr<BatchState>> mQueue;
+    size_t mWorkers = 0;
+};
+
+void BatchPool::submit(const std::shared_ptr<BatchState> &state) {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (mWorkers < poolThreads)
+        startWorkers(poolThreads - mWorkers);
+    mQueue.push_back(state);
+    mCv.notify_all();
+}
+
+void BatchPool::replace(size_t stuck) {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    startWorkers(std::min(stuck, maxPoolThreads - std::min(mWorkers, maxPoolThreads)));
+}
+
+void BatchPool::startWorkers(size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        std::thread(&BatchPool::worker, this).detach();
+        mWorkers++;
+    }
+}
+
+void BatchPool::worker() {
+    std::unique_lock<std::mutex> lock(mLock);
+
+    while (true) {
+        if (mQueue.empty() && mWorkers > poolThreads) {
+            mWorkers--;
+            return;
+        }
+        mCv.wait(lock, [this] { return !mQueue.empty(); });
+        std::shared_ptr<BatchState> state = mQueue.front();
+        lock.unlock();
+
+        const bool more = readNextNode(state.get());
+
+        lock.lock();
+        if (!more && !mQueue.empty() && mQueue.front() == state)
+            mQueue.pop_front();
+    }
+}
+
+std::mutex gPoolLock;
+BatchPool *gPool = nullptr;
+pid_t gPoolPid = 0;
+
+/*
+ * The pool of this process. A child forked by the resident service has none
+ * of its parent's workers, so it starts its own; the parent's pool is left.
+ */
+BatchPool *batchPool() {
+    std::lock_guard<std::mutex> lock(gPoolLock);
+
+    if (!gPool || gPoolPid != getpid()) {
+        gPool = new BatchPool();
+        gPoolPid = getpid();
+    }
+    return gPool;
+}
+
+/* Returns false if the deadline passed; the workers then stop after their current node. */
+bool readWithPool(const std::shared_ptr<BatchState> &state, steady_clock::time_point deadline) {
+    const size_t count = state->nodes.size();
+    BatchPool *pool = batchPool();
+
+    state->deadline = deadline;
+    pool->submit(state);
+
+    std::unique_lock<std::mutex> lock(state->lock);
+    auto finished = [&state, count] { return state->completed == count; };
+    if (deadline == steady_clock::time_point::max()) {
+        state->cv.wait(lock, finished);
+        return true;
+    }
+    if (state->cv.wait_until(lock, deadline, finished))
+        return true;
+    state->abandoned = true;
+    const size_t stuck = state->next - state->completed;
+    lock.unlock();
+    pool->replace(stuck);
+    return false;
+}
+
+/* Whether the node cache is on and may hold one of the nodes of |state|. */
+bool cachedBatch(const BatchState &state) {
+    if (!nodeCacheActive())
+        return false;
+    for (size_t i = 0; i < state.nodes.size(); i++) {
+        if (cachedNodePath(state.path(i)))
+            return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+void disableBatchRing() {
+    gRingUnavailable = true;
+}
+
+NodeBatch::NodeBatch() : mState(std::make_shared<BatchState>()) {}
+
+NodeBatch::~NodeBatch() = default;
+
+size_t NodeBatch::add(const std::string &path) {
+    mState->nodes.push_back({-1, mState->names.size()});
+    mState->names.append(path.c_str(), path.size() + 1);
+    return mState->nodes.size() - 1;
+}
+
+size_t NodeBatch::add(const NodeDir &dir, const char *name) {
+    BatchState *state = mState.get();
+
+    /* Sections interleave the nodes of a few directories, each duplicated once. */
+    auto it = std::find(state->dirs.begin(), state->dirs.end(), &dir);
+    const int index = it - state->dirs.begin();
+    if (it == state->dirs.end()) {
+        state->dirFds.emplace_back(fcntl(dir.fd(), F_DUPFD_CLOEXEC, 0));
+        state->dirPrefixes.push_back(dir.pathOf(""));
+        state->dirs.push_back(&dir);
+    }
+    state->nodes.push_back({index, state->names.size()});
+    state->names.append(name, strlen(name) + 1);
+    return state->nodes.size() - 1;
+}
+
+size_t NodeBatch::size() const {
+    return mState->nodes.size();
+}
+
+std::string NodeBatch::path(size_t index) const {
+    return mState->path(index);
+}
+
+void NodeBatch::read() {
+    BatchState *state = mState.get();
+    const size_t count = state->nodes.size();
+
+    if (!count)
+        return;
+
+    state->results.assign(count, -ENOENT);
+    state->opened.assign(count, false);
+    state->done.assign(count, false);
+    state->readStartNs.assign(count, 0);
+    state->readEndNs.assign(count, 0);
+    state->large.assign(count, std::string());
+    state->inLarge.assign(count, false);
+
+    /*
+     * A capture or replay goes through DumpNode, which records or serves every node, and so
+     * does a batch of nodes that the node cache may serve.
+     */
+    if (packMode() != PackMode::NONE || cachedBatch(*state)) {
+        for (size_t i = 0; i < count; i++) {
+            state->readStartNs[i] = boottimeNs();
+            int error;
+            if (readNodeToString(state->path(i), &state->large[i], &error))
+                state->results[i] = state->large[i].size();
+            else
+                state->results[i] = -error;
+            state->inLarge[i] = true;
+            state->readEndNs[i] = boottimeNs();
+        }
+        return;
+    }
+    state->buffers.reset(new char[count * nodeBufferSize]);
+
+    steady_clock::time_point deadline = nodeAccessDeadline();
+    Ring *ring = threadRing();
+    if (!ring) {
+        readWithPool(mState, deadline);
+    } else if (!readWithRing(ring, state, deadline)) {
+        /*
+         * The kernel may still complete reads into the buffers of this batch,
+         * so neither the ring nor the batch are ever freed. Later batches use
+         * the pool, whose workers free a batch once their reads return, so
+         * this happens at most once per thread.
+         */
+        (void)tRing.release();
+        new std::shared_ptr<BatchState>(mState);
+        disableBatchRing();
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (!state->done[i]) {
+            state->results[i] = -ETIMEDOUT;
+            reportNodeTimeout(state->path(i));
+            continue;
+        }
+        if (state->opened[i])
+            profileFileOpened();
+        if (state->results[i] > 0)
+            profileBytesRead(state->results[i]);
+    }
+}
+
+bool NodeBatch::readTime(size_t index, int64_t *startNs, int64_t *endNs) const {
+    const BatchState *state = mState.get();
+
+    if (index >= state->readStartNs.size() || !state->readStartNs[index] ||
+            state->results[index] < 0)
+        return false;
+    *startNs = state->readStartNs[index];
+    *endNs = state->readEndNs[index];
+    return true;
+}
+
+bool NodeBatch::get(size_t index, std::string *content) const {
+    const BatchState *state = mState.get();
+    ssize_t result = index < state->results.size() ? state->results[index] : -ENOENT;
+
+    if (result < 0) {
+        content->clear();
+        return false;
+    }
+
+    if (state->inLarge[index])
+        content->assign(state->large[index]);
+    else
+        content->assign(&state->buffers[index * nodeBufferSize], result);
+    return true;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+class NodeDir;
+struct BatchState;
+
+/*
+ * Reads a batch of small attribute nodes together. Sections that read many
+ * sysfs attributes add them all first and then read() them at once: with
+ * io_uring the opens, reads and closes of the whole batch are a few
+ * submissions, and where io_uring is unavailable a small persistent thread
+ * pool works through the batch instead.
+ *
+ * Every node is read to its end into its own preallocated buffer of
+ * nodeBufferSize bytes, which holds any sysfs attribute; what doesn't fit,
+ * like a long seq_file debugfs node, continues in a string of its own. The
+ * whole batch shares one node deadline, and nodes left over when it passes
+ * are reported as TIMEOUT.
+ */
+class NodeBatch {
+  public:
+    static constexpr size_t nodeBufferSize = 4096;
+
+    NodeBatch();
+    ~NodeBatch();
+
+    // Adds |path| to the batch and returns its index.
+    size_t add(const std::string &path);
+    // Adds the entry |name| of |dir|, which is opened relative to the directory.
+    size_t add(const NodeDir &dir, const char *name);
+    size_t size() const;
+    std::string path(size_t index) const;
+    void read();
+
+    // Contents of node |index| after read(), with the semantics of readNodeToString().
+    bool get(size_t index, std::string *content) const;
+    // CLOCK_BOOTTIME in ns when the read of node |index| started and ended; false if it wasn't read.
+    bool readTime(size_t index, int64_t *startNs, int64_t *endNs) const;
+
+  private:
+    std::shared_ptr<BatchState> mState;
+};
+
+/*
+ * Reads all batches of the process through the thread pool from now on. A
+ * batch whose ring reads miss their deadline also turns the ring off.
+ */
+void disableBatchRing();
@@ -0,0 +1,223 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Cost of every dump section against synthetic node trees of growing size.
+ * Each benchmark runs one section inline, as dump_power -j1 would, with its
+ * output sent to /dev/null, and reports besides the wall time the heap
+ * allocations, system calls, files opened and bytes read per run. The trees
+ * are built below $DUMP_POWER_TREE, by default /data/local/tmp/dump_power_tree.
+ *
+ * System calls are counted with the raw_syscalls:sys_enter tracepoint, so
+ * that counter is only there when perf events can be opened.
+ */
+
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <android-base/file.h>
+#include <android-base/unique_fd.h>
+#include <benchmark/benchmark.h>
+
+#include "dump_power_io.h"
+#include "dump_power_profile.h"
+#include "dump_power_runner.h"
+#include "dump_power_sections.h"
+#include "dump_power_tree.h"
+
+namespace {
+
+constexpr char defaultTreeRoot[] = "/data/local/tmp/dump_power_tree";
+const int treeScales[] = {1, 4, 16};
+
+std::atomic<uint64_t> gAllocations(0);
+
+}  // namespace
+
+/* Every heap allocation of the benchmark goes through here to be counted. */
+void *operator new(size_t size) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(size ? size : 1);
+    if (!p)
+        abort();
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+namespace {
+
+/* Counts the system calls of the calling thread while it is running. */
+class SyscallCounter {
+  public:
+    SyscallCounter() {
+        std::string id;
+
+        if (!android::base::ReadFileToString("/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+                                             &id) &&
+                !android::base::ReadFileToString(
+                        "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id", &id))
+            return;
+
+        struct perf_event_attr attr = {};
+        attr.type = PERF_TYPE_TRACEPOINT;
+        attr.size = sizeof(attr);
+        attr.config = strtoull(id.c_str(), nullptr, 10);
+        attr.disabled = 1;
+        mFd.reset(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    }
+
+    bool ok() const { return mFd.ok(); }
+
+    void start() {
+        if (!ok())
+            return;
+        ioctl(mFd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(mFd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    uint64_t stop() {
+        uint64_t count = 0;
+
+        if (!ok())
+            return 0;
+        ioctl(mFd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(mFd, &count, sizeof(count)) != sizeof(count))
+            return 0;
+        return count;
+    }
+
+  private:
+    android::base::unique_fd mFd;
+};
+
+/* Sends stdout to /dev/null for the lifetime of the object. */
+class ScopedNullStdout {
+  public:
+    ScopedNullStdout() {
+        fflush(stdout);
+        mSaved.reset(dup(STDOUT_FILENO));
+        android::base::unique_fd null(TEMP_FAILURE_RETRY(open("/dev/null", O_WRONLY | O_CLOEXEC)));
+        dup2(null, STDOUT_FILENO);
+    }
+
+    ~ScopedNullStdout() {
+        fflush(stdout);
+        dup2(mSaved, STDOUT_FILENO);
+    }
+
+  private:
+    android::base::unique_fd mSaved;
+};
+
+/* The tree of |scale|, built on first use. Returns an empty path if it can't be built. */
+std::string treeRoot(int scale) {
+    static std::map<int, std::string> built;
+
+    auto it = built.find(scale);
+    if (it != built.end())
+        return it->second;
+
+    const char *base = getenv("DUMP_POWER_TREE");
+    std::string root = std::string(base ? base : defaultTreeRoot) + "/scale" +
+            std::to_string(scale);
+    NodeTreeScale treeScale;
+    treeScale.mitigationSources *= scale;
+    treeScale.votables *= scale;
+    treeScale.logbufferBytes *= scale;
+
+    mkdir(base ? base : defaultTreeRoot, 0755);
+    if (!buildNodeTree(root, treeScale))
+        root.clear();
+    built[scale] = root;
+    return root;
+}
+
+void sectionBenchmark(benchmark::State &state, const DumpSection *section, int scale) {
+    const std::string root = treeRoot(scale);
+    if (root.empty() || !setNodeRoot(root.c_str())) {
+        state.SkipWithError("Failed to build the node tree");
+        return;
+    }
+
+    SyscallCounter syscalls;
+    SectionProfile totals;
+    uint64_t allocations = 0;
+    uint64_t syscallCount = 0;
+    ScopedNullStdout nullStdout;
+
+    for (auto _ : state) {
+        std::vector<SectionProfile> profiles;
+        SectionRunner runner(section, 1, 1, &profiles);
+
+        const uint64_t allocationsBefore = gAllocations.load(std::memory_order_relaxed);
+        syscalls.start();
+        runner.run();
+        fflush(stdout);
+        syscallCount += syscalls.stop();
+        allocations += gAllocations.load(std::memory_order_relaxed) - allocationsBefore;
+
+        totals.filesOpened += profiles[0].filesOpened;
+        totals.bytesRead += profiles[0].bytesRead;
+        totals.dirScans += profiles[0].dirScans;
+    }
+
+    const auto perRun = benchmark::Counter::kAvgIterations;
+    state.counters["allocs"] = benchmark::Counter(allocations, perRun);
+    if (syscalls.ok())
+        state.counters["syscalls"] = benchmark::Counter(syscallCount, perRun);
+    state.counters["files_opened"] = benchmark::Counter(totals.filesOpened, perRun);
+    state.counters["bytes_read"] = benchmark::Counter(totals.bytesRead, perRun);
+    state.counters["dir_scans"] = benchmark::Counter(totals.dirScans, perRun);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    /* Sections run inline on the benchmark thread, so every cost is accounted to it. */
+    setNodeDeadlines(0, 0);
+
+    for (size_t i = 0; i < dumpSectionCount; i++) {
+        for (int scale : treeScales) {
+            std::string name = std::string("section/") + dumpSections[i].name + "/scale:" +
+                    std::to_string(scale);
+            benchmark::RegisterBenchmark(name.c_str(), sectionBenchmark, &dumpSections[i], scale);
+        }
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return EXIT_FAILURE;
+    benchmark::RunSpecifiedBenchmarks();
+    return EXIT_SUCCESS;
+}
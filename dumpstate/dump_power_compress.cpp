@@ -0,0 +1,171 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_compress.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include <lz4frame.h>
+
+#include "dump_power_io.h"
+#include "dump_power_output.h"
+
+namespace {
+
+constexpr char logbufferPrefix[] = "/dev/logbuffer_";
+constexpr size_t readChunkSize = 32 * 1024;
+/* 57 bytes of input make one 76 character base64 line. */
+constexpr size_t base64LineBytes = 57;
+constexpr size_t base64LinesPerWrite = 64;
+
+constexpr char base64Alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+std::atomic<bool> gCompression(false);
+
+/* Encodes up to 57 bytes of |data| as one base64 line, with its newline, into |line|. */
+size_t base64Line(const uint8_t *data, size_t len, char *line) {
+    size_t out = 0;
+    size_t i;
+
+    for (i = 0; i + 3 <= len; i += 3) {
+        const uint32_t word = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+        line[out++] = base64Alphabet[(word >> 18) & 0x3f];
+        line[out++] = base64Alphabet[(word >> 12) & 0x3f];
+        line[out++] = base64Alphabet[(word >> 6) & 0x3f];
+        line[out++] = base64Alphabet[word & 0x3f];
+    }
+    if (i < len) {
+        const uint32_t word = (data[i] << 16) | (i + 1 < len ? data[i + 1] << 8 : 0);
+        line[out++] = base64Alphabet[(word >> 18) & 0x3f];
+        line[out++] = base64Alphabet[(word >> 12) & 0x3f];
+        line[out++] = i + 1 < len ? base64Alphabet[(word >> 6) & 0x3f] : '=';
+        line[out++] = '=';
+    }
+    line[out++] = '\n';
+    return out;
+}
+
+}  // namespace
+
+void setCompression(bool enabled) {
+    gCompression = enabled;
+}
+
+bool compressionActive() {
+    return gCompression.load(std::memory_order_relaxed);
+}
+
+bool compressedFile(const char *file) {
+    return compressionActive() && !strncmp(file, logbufferPrefix, strlen(logbufferPrefix));
+}
+
+CompressedBlock::CompressedBlock() {
+    mError = LZ4F_createCompressionContext(&mContext, LZ4F_VERSION);
+    if (LZ4F_isError(mError))
+        return;
+
+    mFrame.resize(LZ4F_HEADER_SIZE_MAX);
+    size_t ret = LZ4F_compressBegin(mContext, mFrame.data(), mFrame.size(), nullptr);
+    if (LZ4F_isError(ret)) {
+        mError = ret;
+        return;
+    }
+    mFrame.resize(ret);
+    mError = 0;
+}
+
+CompressedBlock::~CompressedBlock() {
+    if (mContext)
+        LZ4F_freeCompressionContext(mContext);
+}
+
+void CompressedBlock::append(const char *data, size_t len) {
+    if (mError || !len)
+        return;
+
+    /* Only the compressed frame is kept, the input is consumed as it comes. */
+    const size_t start = mFrame.size();
+    mFrame.resize(start + LZ4F_compressBound(len, nullptr));
+    size_t ret = LZ4F_compressUpdate(mContext, mFrame.data() + start, mFrame.size() - start,
+                                     data, len, nullptr);
+    if (LZ4F_isError(ret)) {
+        mError = ret;
+        return;
+    }
+    mFrame.resize(start + ret);
+    mSize += len;
+}
+
+void CompressedBlock::finish() {
+    if (!mError) {
+        const size_t start = mFrame.size();
+        mFrame.resize(start + LZ4F_compressBound(0, nullptr));
+        size_t ret = LZ4F_compressEnd(mContext, mFrame.data() + start, mFrame.size() - start,
+                                      nullptr);
+        if (LZ4F_isError(ret))
+            mError = ret;
+        else
+            mFrame.resize(start + ret);
+    }
+    if (mError) {
+        dumpPrintf("lz4 compression failed: %s\n", LZ4F_getErrorName(mError));
+        return;
+    }
+
+    dumpPrintf("begin-lz4 %zu %zu\n", mSize, mFrame.size());
+
+    const uint8_t *frame = reinterpret_cast<const uint8_t *>(mFrame.data());
+    char text[base64LinesPerWrite * (base64LineBytes / 3 * 4 + 1)];
+    size_t textLen = 0;
+    for (size_t pos = 0; pos < mFrame.size(); pos += base64LineBytes) {
+        textLen += base64Line(frame + pos, std::min(base64LineBytes, mFrame.size() - pos),
+                              text + textLen);
+        if (textLen + base64LineBytes / 3 * 4 + 1 > sizeof(text)) {
+            dumpWrite(text, textLen);
+            textLen = 0;
+        }
+    }
+    dumpWrite(text, textLen);
+    dumpPrintf("end-lz4\n");
+}
+
+void dumpCompressedFile(const char *title, const char *file) {
+    dumpPrintf("------ %s (%s) ------\n", title, file);
+
+    DumpNode node(file);
+    if (!node.ok())
+        return;
+
+    CompressedBlock block;
+    char buffer[readChunkSize];
+    ssize_t len;
+    bool empty = true;
+
+    while ((len = node.read(buffer, sizeof(buffer))) > 0) {
+        block.append(buffer, len);
+        empty = false;
+    }
+    if (len < 0 && empty)
+        return;
+
+    block.finish();
+    dumpWrite("\n", 1);
+}
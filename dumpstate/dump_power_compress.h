@@ -0,0 +1,61 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include <string>
+
+struct LZ4F_cctx_s;
+
+/*
+ * Compressed text output for the bulky files, the logbuffers and register
+ * dumps. Their content is fed through an LZ4 frame compressor as it is read
+ * and written as one block between marker lines:
+ *
+ *   begin-lz4 <uncompressed bytes> <compressed bytes>
+ *   <the LZ4 frame in base64, 76 characters per line>
+ *   end-lz4
+ *
+ * so that `sed '1d;$d' | base64 -d | lz4 -d` restores the file. Everything
+ * else, and structured output, stays as it is.
+ */
+
+// Compresses the bulky files from now on. Must be set before sections start.
+void setCompression(bool enabled);
+bool compressionActive();
+// Whether dumpFileContent() writes |file| as a compressed block.
+bool compressedFile(const char *file);
+
+// One compressed block, written to the section output by finish().
+class CompressedBlock {
+  public:
+    CompressedBlock();
+    ~CompressedBlock();
+
+    void append(const char *data, size_t len);
+    void finish();
+
+  private:
+    LZ4F_cctx_s *mContext = nullptr;
+    std::string mFrame;
+    size_t mSize = 0;
+    size_t mError = 0;
+};
+
+// dumpFileContent() of |file| as a compressed block.
+void dumpCompressedFile(const char *title, const char *file);
@@ -0,0 +1,321 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_cpuidle.h"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <android-base/strings.h>
+#include <android-base/unique_fd.h>
+
+#include "dump_power_io.h"
+#include "dump_power_output.h"
+#include "dump_power_record.h"
+#include "dump_power_table.h"
+
+using android::base::StringPrintf;
+
+namespace {
+
+constexpr char baselineMagic[] = "dump_power cpuidle baseline 1";
+constexpr char bootIdPath[] = "/proc/sys/kernel/random/boot_id";
+
+constexpr int percentiles[] = {50, 90, 99};
+
+bool gBaselineActive = false;
+std::string gBaselinePath;
+std::string gBootId;
+
+/* Bucket counts of the previous dump by "<file>\t<group>\t<state>". Read only once loaded. */
+std::unordered_map<std::string, std::vector<uint64_t>> gBaseline;
+
+std::mutex gCountsLock;
+std::map<std::string, std::vector<uint64_t>> gCounts;
+
+/* Parses the whitespace separated counts of |text|. False if one isn't a count. */
+bool parseCounts(std::string_view text, std::vector<uint64_t> *counts) {
+    while (true) {
+        text = trimmed(text);
+        if (text.empty())
+            return true;
+
+        size_t end = text.find_first_of(" \t");
+        int64_t count;
+        if (!parseInt(text.substr(0, end), &count) || count < 0)
+            return false;
+        counts->push_back(count);
+        if (end == std::string_view::npos)
+            return true;
+        text.remove_prefix(end);
+    }
+}
+
+std::string countsKey(const char *file, const IdleHistogram &histogram) {
+    return std::string(file) + "\t" + std::string(histogram.group) + "\t" +
+           std::string(histogram.state);
+}
+
+/* Loads the bucket counts of |path| if they were saved on this boot. */
+void loadBaseline(const std::string &path) {
+    std::string content;
+
+    if (!android::base::ReadFileToString(path, &content))
+        return;
+
+    std::vector<std::string> lines = android::base::Split(content, "\n");
+    if (lines.size() < 2 || lines[0] != baselineMagic || lines[1] != "boot_id\t" + gBootId)
+        return;
+
+    for (size_t i = 2; i < lines.size(); i++) {
+        /* <file>\t<group>\t<state>\t<counts> */
+        size_t tab = lines[i].rfind('\t');
+        std::vector<uint64_t> counts;
+        if (tab == std::string::npos || !parseCounts(std::string_view(lines[i]).substr(tab + 1),
+                                                     &counts))
+            continue;
+        gBaseline[lines[i].substr(0, tab)] = std::move(counts);
+    }
+}
+
+/* Entries of |current| since |previous|, or nothing if the counts went back, as on a reset. */
+std::vector<uint64_t> countsSince(const std::vector<uint64_t> &current,
+                                  const std::vector<uint64_t> *previous) {
+    std::vector<uint64_t> since;
+
+    if (!previous || previous->size() != current.size())
+        return since;
+    for (size_t i = 0; i < current.size(); i++) {
+        if (current[i] < (*previous)[i])
+            return {};
+        since.push_back(current[i] - (*previous)[i]);
+    }
+    return since;
+}
+
+uint64_t entries(const std::vector<uint64_t> &buckets) {
+    uint64_t total = 0;
+
+    for (uint64_t count : buckets)
+        total += count;
+    return total;
+}
+
+/* The entries and percentile columns of |buckets|, as dashes if there are none to compare. */
+std::string summaryColumns(const std::vector<uint64_t> &buckets, bool known) {
+    if (!known)
+        return StringPrintf("%12s %4s %4s %4s", "-", "-", "-", "-");
+
+    std::string columns = StringPrintf("%12" PRIu64, entries(buckets));
+    for (int percent : percentiles) {
+        int bucket = histogramPercentile(buckets, percent);
+        columns += bucket < 0 ? StringPrintf(" %4s", "-") : StringPrintf(" %4d", bucket);
+    }
+    return columns;
+}
+
+void recordSummary(const std::string &key, const std::vector<uint64_t> &buckets,
+                   const char *file) {
+    dumpRecord(key + "entries", entries(buckets), file);
+    for (int percent : percentiles) {
+        int bucket = histogramPercentile(buckets, percent);
+        if (bucket >= 0)
+            dumpRecord(key + "p" + std::to_string(percent), bucket, file);
+    }
+}
+
+std::string shallowRatio(uint64_t shallow, uint64_t deep) {
+    return deep ? StringPrintf("%.3f", static_cast<double>(shallow) / deep) : "-";
+}
+
+/*
+ * Shallowest state entries per deeper state entry of each group, in total and
+ * since the baseline.
+ */
+struct GroupRatio {
+    std::string_view group;
+    uint64_t shallow = 0;
+    uint64_t deep = 0;
+    uint64_t shallowSince = 0;
+    uint64_t deepSince = 0;
+    bool knownSince = true;
+};
+
+}  // namespace
+
+std::vector<IdleHistogram> parseIdleHistogram(std::string_view content) {
+    std::vector<IdleHistogram> histograms;
+    std::string_view group;
+    std::string_view line;
+
+    LineReader reader(content);
+    while (reader.next(&line)) {
+        line = trimmed(line);
+        if (line.empty())
+            continue;
+
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) {
+            group = line;
+            continue;
+        }
+
+        IdleHistogram histogram = {group, trimmed(line.substr(0, colon)), {}};
+        if (parseCounts(line.substr(colon + 1), &histogram.buckets) &&
+                !histogram.buckets.empty())
+            histograms.push_back(std::move(histogram));
+    }
+    return histograms;
+}
+
+int histogramPercentile(const std::vector<uint64_t> &buckets, int percent) {
+    const uint64_t total = entries(buckets);
+    if (!total)
+        return -1;
+
+    /* The first bucket whose cumulative count reaches the rank of the percentile. */
+    const uint64_t rank = (total * percent + 99) / 100;
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < buckets.size(); i++) {
+        cumulative += buckets[i];
+        if (cumulative >= rank)
+            return i;
+    }
+    return buckets.size() - 1;
+}
+
+void setCpuidleBaseline(const char *path) {
+    gBaselineActive = true;
+    gBaselinePath = path;
+    if (android::base::ReadFileToString(bootIdPath, &gBootId))
+        gBootId = android::base::Trim(gBootId);
+    loadBaseline(gBaselinePath);
+}
+
+bool saveCpuidleBaseline() {
+    std::string content = std::string(baselineMagic) + "\n";
+    content += "boot_id\t" + gBootId + "\n";
+    {
+        std::lock_guard<std::mutex> lock(gCountsLock);
+        /* Histograms this dump didn't read keep their counts. */
+        for (const auto &[key, counts] : gBaseline)
+            gCounts.emplace(key, counts);
+        for (const auto &[key, counts] : gCounts) {
+            content += key + "\t";
+            for (size_t i = 0; i < counts.size(); i++)
+                content += (i ? " " : "") + std::to_string(counts[i]);
+            content += "\n";
+        }
+    }
+
+    /* Written aside and renamed, so a dump killed halfway never leaves a torn baseline. */
+    std::string tmpPath = gBaselinePath + ".tmp";
+    android::base::unique_fd fd(TEMP_FAILURE_RETRY(
+            open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600)));
+    if (!fd.ok())
+        return false;
+    if (!android::base::WriteStringToFd(content, fd) || fsync(fd)) {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return rename(tmpPath.c_str(), gBaselinePath.c_str()) == 0;
+}
+
+void dumpCpuidleHistogram(const char *title, const char *file) {
+    /* Read once, so that the summary is of the very counts printed above it. */
+    std::string content;
+    const bool read = readNodeToString(file, &content) || !content.empty();
+    dumpNodeContent(title, file, read ? &content : nullptr);
+    if (!read)
+        return;
+    const std::vector<IdleHistogram> histograms = parseIdleHistogram(content);
+    if (histograms.empty())
+        return;
+
+    const std::string summaryTitle = std::string(title) + " summary";
+    if (!structuredOutput()) {
+        dumpPrintf("------ %s (%s) ------\n", summaryTitle.c_str(), file);
+        dumpPrintf("percentiles are bucket indexes, \"new\" is since the previous dump\n");
+        dumpPrintf("%-12s %-12s %12s %4s %4s %4s %12s %4s %4s %4s\n", "group", "state",
+                   "entries", "p50", "p90", "p99", "new", "p50", "p90", "p99");
+    }
+
+    std::vector<GroupRatio> ratios;
+    for (const IdleHistogram &histogram : histograms) {
+        const std::string key = countsKey(file, histogram);
+        const std::vector<uint64_t> *previous = nullptr;
+        if (gBaselineActive) {
+            std::lock_guard<std::mutex> lock(gCountsLock);
+            gCounts[key] = histogram.buckets;
+            auto it = gBaseline.find(key);
+            if (it != gBaseline.end())
+                previous = &it->second;
+        }
+        const std::vector<uint64_t> since = countsSince(histogram.buckets, previous);
+        const bool knownSince = previous && since.size() == histogram.buckets.size();
+
+        /* The first state of a group is its shallowest. */
+        if (ratios.empty() || ratios.back().group != histogram.group) {
+            ratios.push_back({histogram.group});
+            ratios.back().shallow = entries(histogram.buckets);
+            ratios.back().shallowSince = entries(since);
+        } else {
+            ratios.back().deep += entries(histogram.buckets);
+            ratios.back().deepSince += entries(since);
+        }
+        ratios.back().knownSince &= knownSince;
+
+        if (structuredOutput()) {
+            std::string recordKey = summaryTitle + "." + std::string(histogram.group) + "." +
+                                    std::string(histogram.state) + ".";
+            recordSummary(recordKey, histogram.buckets, file);
+            if (knownSince)
+                recordSummary(recordKey + "new_", since, file);
+            continue;
+        }
+
+        dumpPrintf("%-12.*s %-12.*s %s %s\n", static_cast<int>(histogram.group.size()),
+                   histogram.group.data(), static_cast<int>(histogram.state.size()),
+                   histogram.state.data(), summaryColumns(histogram.buckets, true).c_str(),
+                   summaryColumns(since, knownSince).c_str());
+    }
+
+    for (const GroupRatio &ratio : ratios) {
+        const std::string total = shallowRatio(ratio.shallow, ratio.deep);
+        const std::string since = ratio.knownSince
+                ? shallowRatio(ratio.shallowSince, ratio.deepSince) : "-";
+
+        if (structuredOutput()) {
+            const std::string key = summaryTitle + "." + std::string(ratio.group) + ".";
+            dumpRecordValue(key + "shallow_deep_ratio", total, file);
+            if (ratio.knownSince)
+                dumpRecordValue(key + "new_shallow_deep_ratio", since, file);
+            continue;
+        }
+        dumpPrintf("%-12.*s shallow/deep %s, new %s\n", static_cast<int>(ratio.group.size()),
+                   ratio.group.data(), total.c_str(), since.c_str());
+    }
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string_view>
+#include <vector>
+
+/*
+ * Summary of the cpuidle histograms. A histogram node has a heading line per
+ * cpu or cluster followed by a "<state>: <count> <count> ..." line of bucket
+ * counts for each of its idle states. Below the raw node the dump writes, for
+ * every state, the bucket below which 50, 90 and 99 percent of the idle entries
+ * fall, and for every cpu how many entries stayed in its shallowest state per
+ * entry into a deeper one. The same figures follow for the entries since the
+ * previous dump of this boot, whose bucket counts are kept in a baseline file.
+ *
+ * The nodes don't say which durations the buckets stand for, so percentiles
+ * are bucket indexes.
+ */
+constexpr char defaultCpuidleBaseline[] = "/data/vendor/dump_power/cpuidle_baseline";
+
+struct IdleHistogram {
+    // Heading of the cpu or cluster, empty before the first heading.
+    std::string_view group;
+    std::string_view state;
+    std::vector<uint64_t> buckets;
+};
+
+// Parses the state lines of |content|; the views point into it.
+std::vector<IdleHistogram> parseIdleHistogram(std::string_view content);
+// Index of the bucket where |percent| percent of the entries are reached, or -1 if there are none.
+int histogramPercentile(const std::vector<uint64_t> &buckets, int percent);
+
+// Loads the bucket counts of the previous dump from |path|, and saves this dump's there.
+void setCpuidleBaseline(const char *path);
+bool saveCpuidleBaseline();
+
+// dumpFileContent() of the histogram |file|, followed by its summary.
+void dumpCpuidleHistogram(const char *title, const char *file);
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_delta.h"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <android-base/file.h>
+#include <android-base/strings.h>
+#include <android-base/unique_fd.h>
+
+#include "dump_power_output.h"
+#include "dump_power_record.h"
+
+namespace {
+
+constexpr char snapshotMagic[] = "dump_power snapshot 1";
+constexpr char bootIdPath[] = "/proc/sys/kernel/random/boot_id";
+
+constexpr uint64_t fnvOffset = 0xcbf29ce484222325ULL;
+constexpr uint64_t fnvPrime = 0x100000001b3ULL;
+
+uint64_t fnv1a(uint64_t hash, const void *data, size_t len) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+
+    for (size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= fnvPrime;
+    }
+    return hash;
+}
+
+struct DeltaState {
+    const char *section = nullptr;
+    uint64_t hash = fnvOffset;
+    std::unordered_map<std::string, int> keyCount;
+};
+
+bool gDeltaActive = false;
+std::string gSnapshotPath;
+std::string gBootId;
+std::string gFormat;
+
+/* Baseline hashes, keyed "S\t<section>" and "K\t<section>\t<key>". Read only once loaded. */
+std::unordered_map<std::string, uint64_t> gBaseline;
+std::string gBaselineTime;
+bool gHaveBaseline = false;
+
+std::mutex gSnapshotLock;
+std::map<std::string, uint64_t> gSnapshot;
+
+/* State of the section running on the calling thread; section is null outside of one. */
+thread_local DeltaState tDelta;
+
+void recordHash(const std::string &id, uint64_t hash) {
+    std::lock_guard<std::mutex> lock(gSnapshotLock);
+    gSnapshot[id] = hash;
+}
+
+bool unchangedSince(const std::string &id, uint64_t hash) {
+    if (!gHaveBaseline)
+        return false;
+
+    auto it = gBaseline.find(id);
+    return it != gBaseline.end() && it->second == hash;
+}
+
+/* The section of a snapshot id, which is its second tab-separated field. */
+std::string idSection(const std::string &id) {
+    const size_t start = id.find('\t') + 1;
+    const size_t end = id.find('\t', start);
+    return id.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+/* Loads |path| as baseline if it was taken on this boot in the same output format. */
+void loadBaseline(const std::string &path) {
+    std::string content;
+
+    if (!android::base::ReadFileToString(path, &content))
+        return;
+
+    std::vector<std::string> lines = android::base::Split(content, "\n");
+    if (lines.size() < 4 || lines[0] != snapshotMagic || lines[1] != "boot_id\t" + gBootId ||
+            lines[2] != "format\t" + gFormat || !android::base::StartsWith(lines[3], "time\t"))
+        return;
+    gBaselineTime = lines[3].substr(strlen("time\t"));
+
+    for (size_t i = 4; i < lines.size(); i++) {
+        /* <hash>\t<id>, where the id itself has tabs. */
+        size_t tab = lines[i].find('\t');
+        if (tab == std::string::npos)
+            continue;
+        gBaseline[lines[i].substr(tab + 1)] = strtoull(lines[i].c_str(), nullptr, 16);
+    }
+    gHaveBaseline = true;
+}
+
+}  // namespace
+
+void setDeltaSnapshot(const char *path) {
+    gDeltaActive = true;
+    gSnapshotPath = path;
+    gFormat = structuredOutput() ? "json" : "text";
+    if (android::base::ReadFileToString(bootIdPath, &gBootId))
+        gBootId = android::base::Trim(gBootId);
+    loadBaseline(gSnapshotPath);
+}
+
+bool deltaActive() {
+    return gDeltaActive;
+}
+
+void printDeltaHeader() {
+    if (structuredOutput()) {
+        ScopedRecordSection scopedRecords("dump_power_delta");
+        dumpRecord("baseline", gHaveBaseline ? gBaselineTime : "none", gSnapshotPath);
+        dumpRecord("boot_id", gBootId, bootIdPath);
+        return;
+    }
+
+    if (gHaveBaseline)
+        dumpPrintf("------ dump_power delta against %s (%s) ------\n", gBaselineTime.c_str(),
+                   gSnapshotPath.c_str());
+    else
+        dumpPrintf("------ dump_power delta: no baseline for this boot, full dump (%s) ------\n",
+                   gSnapshotPath.c_str());
+}
+
+bool saveDeltaSnapshot() {
+    char now[32];
+    time_t t = time(nullptr);
+    struct tm tm;
+
+    strftime(now, sizeof(now), "%Y-%m-%d %H:%M:%S", localtime_r(&t, &tm));
+
+    std::string content = std::string(snapshotMagic) + "\n";
+    content += "boot_id\t" + gBootId + "\n";
+    content += "format\t" + gFormat + "\n";
+    content += std::string("time\t") + now + "\n";
+    {
+        std::lock_guard<std::mutex> lock(gSnapshotLock);
+        std::map<std::string, uint64_t> snapshot = gSnapshot;
+
+        /*
+         * Every section that ran has recorded its own hash. The baseline of the sections that
+         * didn't, such as those left out by --sections or the budget, is carried over as is.
+         */
+        for (const auto &[id, hash] : gBaseline) {
+            if (!gSnapshot.count("S\t" + idSection(id)))
+                snapshot.emplace(id, hash);
+        }
+        for (const auto &[id, hash] : snapshot) {
+            char hex[20];
+            snprintf(hex, sizeof(hex), "%016" PRIx64 "\t", hash);
+            content += hex + id + "\n";
+        }
+    }
+
+    /* Written aside and renamed, so a dump killed halfway never leaves a torn baseline. */
+    std::string tmpPath = gSnapshotPath + ".tmp";
+    android::base::unique_fd fd(TEMP_FAILURE_RETRY(
+            open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600)));
+    if (!fd.ok())
+        return false;
+    if (!android::base::WriteStringToFd(content, fd) || fsync(fd)) {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return rename(tmpPath.c_str(), gSnapshotPath.c_str()) == 0;
+}
+
+ScopedDeltaSection::ScopedDeltaSection(const char *name) : mName(name) {
+    if (gDeltaActive)
+        tDelta.section = name;
+}
+
+ScopedDeltaSection::~ScopedDeltaSection() {
+    if (!tDelta.section)
+        return;
+
+    const std::string id = std::string("S\t") + mName;
+    const uint64_t hash = tDelta.hash;
+    tDelta = DeltaState();
+
+    recordHash(id, hash);
+    if (!unchangedSince(id, hash))
+        return;
+
+    discardSectionOutput();
+    discardRecordText();
+    if (structuredOutput()) {
+        dumpMarkerRecord("unchanged", "");
+    } else {
+        std::string marker = std::string("------ ") + mName + ": unchanged ------\n";
+        dumpWriteRaw(marker.data(), marker.size());
+    }
+}
+
+void deltaText(const char *data, size_t len) {
+    if (tDelta.section)
+        tDelta.hash = fnv1a(tDelta.hash, data, len);
+}
+
+bool deltaKeyChanged(const std::string &key, const std::string &path, const std::string &value) {
+    if (!tDelta.section)
+        return true;
+
+    /* Repeated keys in a section are numbered, so each is compared with its own predecessor. */
+    std::string name = key + " (" + path + ")";
+    int count = ++tDelta.keyCount[name];
+    if (count > 1)
+        name += "#" + std::to_string(count);
+
+    const std::string id = std::string("K\t") + tDelta.section + "\t" + name;
+    const uint64_t hash = fnv1a(fnv1a(fnvOffset, name.data(), name.size()), value.data(),
+                                value.size());
+
+    /* The section hash covers its keys by their hashes, whether they are written out or not. */
+    tDelta.hash = fnv1a(tDelta.hash, id.data(), id.size() + 1);
+    tDelta.hash = fnv1a(tDelta.hash, &hash, sizeof(hash));
+
+    recordHash(id, hash);
+    return !unchangedSince(id, hash);
+}
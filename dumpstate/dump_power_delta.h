@@ -0,0 +1,59 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include <string>
+
+/*
+ * Delta dumps. Every run in delta mode stores a snapshot with a hash of each
+ * section and of each key in it, where a key is a file dumped with
+ * dumpFileContent() or a typed record. The next run on the same boot compares
+ * against that baseline and only writes the keys and sections that changed:
+ * an unchanged key is reduced to a one line marker, and an unchanged section
+ * to a single marker in place of its whole output.
+ */
+constexpr char defaultDeltaSnapshot[] = "/data/vendor/dump_power/snapshot";
+
+// Turns delta mode on and loads the baseline from |path|, if it is usable.
+void setDeltaSnapshot(const char *path);
+bool deltaActive();
+
+// Writes the reference to the baseline the dump is relative to.
+void printDeltaHeader();
+// Replaces |path| with the snapshot of this run. Sections it didn't run keep their baseline.
+bool saveDeltaSnapshot();
+
+/*
+ * Hashes everything the calling thread writes as the section |name|. If the
+ * section turns out to be unchanged when the object goes away, its output so
+ * far is dropped and replaced with the unchanged marker.
+ */
+class ScopedDeltaSection {
+  public:
+    explicit ScopedDeltaSection(const char *name);
+    ~ScopedDeltaSection();
+
+  private:
+    const char *mName;
+};
+
+// Adds free text of the current section to its hash.
+void deltaText(const char *data, size_t len);
+// Records |value| under |key| and returns whether it differs from the baseline.
+bool deltaKeyChanged(const std::string &key, const std::string &path, const std::string &value);
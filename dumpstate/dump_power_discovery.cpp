@@ -0,0 +1,90 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_discovery.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+
+#include "dump_power_io.h"
+#include "dump_power_pack.h"
+
+namespace {
+
+std::atomic<bool> gCacheEnabled(false);
+
+/* Probe results keyed "D\t<path>", "N\t<path>" and "E\t<directory>\t<match>". */
+std::mutex gCacheLock;
+std::map<std::string, std::vector<std::string>> gCache;
+
+bool cacheActive() {
+    return gCacheEnabled.load(std::memory_order_relaxed) && packMode() == PackMode::NONE;
+}
+
+/* Result of |probe| under |key|, probed on a miss. Probes run unlocked and may race benignly. */
+template <typename Probe>
+std::vector<std::string> cached(const std::string &key, Probe probe) {
+    if (!cacheActive())
+        return probe();
+
+    {
+        std::lock_guard<std::mutex> lock(gCacheLock);
+        auto it = gCache.find(key);
+        if (it != gCache.end())
+            return it->second;
+    }
+
+    std::vector<std::string> result = probe();
+    std::lock_guard<std::mutex> lock(gCacheLock);
+    gCache.emplace(key, result);
+    return result;
+}
+
+}  // namespace
+
+void enableDiscoveryCache() {
+    gCacheEnabled = true;
+}
+
+void invalidateDiscovery() {
+    std::lock_guard<std::mutex> lock(gCacheLock);
+    gCache.clear();
+}
+
+bool discoverDir(const char *path) {
+    return !cached(std::string("D\t") + path, [path] {
+        NodeDir dir(path);
+        return dir.ok() ? std::vector<std::string>{path} : std::vector<std::string>();
+    }).empty();
+}
+
+bool discoverNode(const char *path) {
+    return !cached(std::string("N\t") + path, [path] {
+        DumpNode node(path);
+        return node.ok() ? std::vector<std::string>{path} : std::vector<std::string>();
+    }).empty();
+}
+
+std::vector<std::string> discoverEntries(const char *directory, const char *match) {
+    return cached(std::string("E\t") + directory + "\t" + match, [directory, match] {
+        NodeDir dir(directory);
+        std::vector<std::string> names;
+        for (const char *name : dir.list(NodeDir::SUBSTRING, match))
+            names.push_back(name);
+        return names;
+    });
+}
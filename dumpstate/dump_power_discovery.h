@@ -0,0 +1,42 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/*
+ * Device topology that the sections look up before they dump, such as which
+ * fuel gauge is present or the name of the tcpm power supply. A one-shot dump
+ * probes it every time. The resident service turns the cache on, so that its
+ * dumps find the topology already probed, and drops it whenever a uevent says
+ * that devices came or went.
+ *
+ * The cache is bypassed while a pack is captured or replayed, so that packs
+ * hold every access of the dump.
+ */
+
+// Keeps the results of the probes below until invalidateDiscovery().
+void enableDiscoveryCache();
+void invalidateDiscovery();
+
+// Whether |path| can be opened as a directory.
+bool discoverDir(const char *path);
+// Whether |path| can be opened as a node.
+bool discoverNode(const char *path);
+// Entries of |directory| with |match| in their name, in directory order.
+std::vector<std::string> discoverEntries(const char *directory, const char *match);
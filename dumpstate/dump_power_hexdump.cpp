@@ -0,0 +1,127 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_hexdump.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <array>
+
+#include "dump_power_io.h"
+#include "dump_power_output.h"
+
+namespace {
+
+constexpr size_t readChunkSize = 4096;
+constexpr size_t linesPerChunk = readChunkSize / hexDumpBytesPerLine;
+
+/* Two lower case hex digits for every byte value, looked up instead of formatted. */
+constexpr std::array<char, 512> makeHexPairs() {
+    const char digits[] = "0123456789abcdef";
+    std::array<char, 512> pairs{};
+    for (int i = 0; i < 256; i++) {
+        pairs[i * 2] = digits[i >> 4];
+        pairs[i * 2 + 1] = digits[i & 0xf];
+    }
+    return pairs;
+}
+
+constexpr std::array<char, 512> hexPairs = makeHexPairs();
+
+/* xxd prints 0x20..0x7e as is and everything else as '.'. */
+constexpr std::array<char, 256> makePrintable() {
+    std::array<char, 256> printable{};
+    for (int i = 0; i < 256; i++)
+        printable[i] = (i >= 0x20 && i < 0x7f) ? static_cast<char>(i) : '.';
+    return printable;
+}
+
+constexpr std::array<char, 256> printableChars = makePrintable();
+
+}  // namespace
+
+size_t formatHexDumpLine(uint64_t offset, const uint8_t *data, size_t len, char *line) {
+    char *out = line;
+    int digits = 8;
+
+    while (digits < 16 && (offset >> (digits * 4)) != 0)
+        digits++;
+    for (int shift = (digits - 1) * 4; shift >= 0; shift -= 4)
+        *out++ = hexPairs[((offset >> shift) & 0xf) * 2 + 1];
+    *out++ = ':';
+    *out++ = ' ';
+
+    for (size_t i = 0; i < hexDumpBytesPerLine; i++) {
+        if (i < len) {
+            memcpy(out, &hexPairs[data[i] * 2], 2);
+        } else {
+            out[0] = ' ';
+            out[1] = ' ';
+        }
+        out += 2;
+        if ((i & 1) && i != hexDumpBytesPerLine - 1)
+            *out++ = ' ';
+    }
+    *out++ = ' ';
+    *out++ = ' ';
+
+    for (size_t i = 0; i < len; i++)
+        *out++ = printableChars[data[i]];
+    *out++ = '\n';
+
+    return out - line;
+}
+
+int dumpHexFile(const char *file) {
+    DumpNode node(file);
+    uint8_t data[readChunkSize];
+    char text[linesPerChunk * hexDumpLineMax];
+    uint64_t offset = 0;
+    size_t pending = 0;
+    bool eof = false;
+
+    if (!node.ok())
+        return -1;
+
+    while (!eof) {
+        ssize_t ret = node.read(data + pending, sizeof(data) - pending);
+        if (ret <= 0)
+            eof = true;
+        else
+            pending += ret;
+
+        /* Only full lines are formatted until the end of the file is reached. */
+        size_t usable = eof ? pending : pending - pending % hexDumpBytesPerLine;
+        size_t textLen = 0;
+        size_t pos;
+        for (pos = 0; pos < usable; pos += hexDumpBytesPerLine) {
+            size_t len = std::min(hexDumpBytesPerLine, usable - pos);
+            textLen += formatHexDumpLine(offset + pos, data + pos, len, text + textLen);
+        }
+        dumpWrite(text, textLen);
+
+        offset += pos;
+        memmove(data, data + usable, pending - usable);
+        pending -= usable;
+    }
+
+    /* An empty file still terminates the section with a newline. */
+    if (offset == 0)
+        dumpWrite("\n", 1);
+
+    return 0;
+}
@@ -0,0 +1,35 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Formats up to 16 bytes at |offset| as one line of `xxd` output, including the
+ * trailing newline. |line| must hold at least hexDumpLineMax bytes. Returns the
+ * number of characters written.
+ */
+constexpr size_t hexDumpBytesPerLine = 16;
+constexpr size_t hexDumpLineMax = 96;
+size_t formatHexDumpLine(uint64_t offset, const uint8_t *data, size_t len, char *line);
+
+/*
+ * Streams |file| through the section output in the same layout as `xxd file`,
+ * reading it in fixed size chunks. Returns -1 if the file can't be opened.
+ */
+int dumpHexFile(const char *file);
@@ -0,0 +1,276 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_history.h"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <android-base/unique_fd.h>
+
+#include "dump_power_batch.h"
+#include "dump_power_io.h"
+#include "dump_power_output.h"
+#include "dump_power_record.h"
+
+namespace {
+
+constexpr char historyMagic[8] = {'D', 'P', 'H', 'I', 'S', 'T', '1', '\0'};
+constexpr uint32_t historySlotSize = 4096;
+constexpr uint32_t historySlotCount = 512;
+constexpr char powerSupplyDir[] = "/sys/class/power_supply/";
+
+/* The header takes the first slot, so that every slot is page aligned. */
+struct HistoryHeader {
+    char magic[8];
+    uint32_t slotSize;
+    uint32_t slotCount;
+    // Sequence number of the next sample; slot (seq - 1) % slotCount holds sample seq.
+    uint64_t nextSeq;
+};
+
+constexpr uint32_t slotTruncated = 1 << 0;
+constexpr int64_t nsPerMs = 1000000;
+constexpr int64_t nsPerSec = 1000000000;
+
+struct HistorySlot {
+    // Zero while the slot is being written.
+    uint64_t seq;
+    int64_t realtimeNs;
+    int64_t boottimeNs;
+    uint32_t len;
+    uint32_t flags;
+    char path[96];
+    char data[historySlotSize - 128];
+};
+static_assert(sizeof(HistorySlot) == historySlotSize);
+
+constexpr size_t historyFileSize = historySlotSize * (historySlotCount + 1);
+
+std::string gHistoryFile = defaultHistoryFile;
+int gHistoryMinutes = defaultHistoryMinutes;
+
+int64_t nowNs(clockid_t clock) {
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * nsPerSec + ts.tv_nsec;
+}
+
+HistorySlot *slotAt(void *map, uint64_t index) {
+    return reinterpret_cast<HistorySlot *>(static_cast<char *>(map) + historySlotSize * (index + 1));
+}
+
+bool validHeader(const HistoryHeader *header) {
+    return !memcmp(header->magic, historyMagic, sizeof(historyMagic)) &&
+            header->slotSize == historySlotSize && header->slotCount == historySlotCount;
+}
+
+void appendSample(void *map, const std::string &path, const std::string &content) {
+    HistoryHeader *header = static_cast<HistoryHeader *>(map);
+    const uint64_t seq = header->nextSeq++;
+    HistorySlot *slot = slotAt(map, (seq - 1) % historySlotCount);
+
+    /*
+     * A reader that sees the slot change under it drops the sample. The fence
+     * keeps the stores below from being seen before the slot is marked.
+     */
+    __atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot->realtimeNs = nowNs(CLOCK_REALTIME);
+    slot->boottimeNs = nowNs(CLOCK_BOOTTIME);
+    slot->len = std::min(content.size(), sizeof(slot->data));
+    slot->flags = content.size() > sizeof(slot->data) ? slotTruncated : 0;
+    strncpy(slot->path, path.c_str(), sizeof(slot->path) - 1);
+    slot->path[sizeof(slot->path) - 1] = '\0';
+    memcpy(slot->data, content.data(), slot->len);
+    __atomic_store_n(&slot->seq, seq, __ATOMIC_RELEASE);
+}
+
+std::vector<std::string> powerSupplyUevents() {
+    std::vector<std::string> sources;
+    NodeDir dir(powerSupplyDir);
+
+    for (const char *supply : dir.list())
+        sources.push_back(dir.pathOf(supply) + "/uevent");
+    return sources;
+}
+
+struct SourceState {
+    std::string last;
+    int64_t storedNs = 0;
+};
+
+}  // namespace
+
+int runRecorder(const RecorderConfig &config) {
+    android::base::unique_fd fd(TEMP_FAILURE_RETRY(
+            open(config.file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600)));
+    if (!fd.ok()) {
+        fprintf(stderr, "Failed to open %s: %s\n", config.file.c_str(), strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) || (static_cast<size_t>(st.st_size) != historyFileSize &&
+            ftruncate(fd, historyFileSize))) {
+        fprintf(stderr, "Failed to size %s: %s\n", config.file.c_str(), strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    void *map = mmap(nullptr, historyFileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Failed to map %s: %s\n", config.file.c_str(), strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    /* Samples of an earlier recorder are kept, so a history survives a restart or reboot. */
+    HistoryHeader *header = static_cast<HistoryHeader *>(map);
+    if (!validHeader(header) || !header->nextSeq) {
+        memset(map, 0, historyFileSize);
+        memcpy(header->magic, historyMagic, sizeof(historyMagic));
+        header->slotSize = historySlotSize;
+        header->slotCount = historySlotCount;
+        header->nextSeq = 1;
+    }
+
+    std::vector<std::string> sources = config.sources;
+    std::vector<SourceState> states;
+    int64_t discoveredNs = 0;
+
+    /* A ring that misses a deadline can't be freed, which a daemon can't afford. */
+    disableBatchRing();
+
+    while (true) {
+        const int64_t now = nowNs(CLOCK_BOOTTIME);
+
+        /* Power supplies come and go with chargers and PD partners, so look again now and then. */
+        if (config.sources.empty() && now - discoveredNs >= config.keyframeMs * nsPerMs) {
+            std::vector<std::string> discovered = powerSupplyUevents();
+            if (discovered != sources) {
+                sources = std::move(discovered);
+                states.clear();
+            }
+            discoveredNs = now;
+        }
+        states.resize(sources.size());
+
+        NodeBatch batch;
+        for (const auto &source : sources)
+            batch.add(source);
+        batch.read();
+
+        std::string content;
+        for (size_t i = 0; i < sources.size(); i++) {
+            if (!batch.get(i, &content))
+                continue;
+
+            SourceState &state = states[i];
+            if (content == state.last && state.storedNs &&
+                    now - state.storedNs < config.keyframeMs * nsPerMs)
+                continue;
+
+            appendSample(map, sources[i], content);
+            state.last = content;
+            state.storedNs = now;
+        }
+
+        usleep(config.intervalMs * 1000);
+    }
+}
+
+void setHistory(const std::string &file, int minutes) {
+    gHistoryFile = file;
+    gHistoryMinutes = minutes;
+}
+
+void dumpHistory() {
+    struct Sample {
+        uint64_t seq;
+        int64_t realtimeNs;
+        int64_t boottimeNs;
+        bool truncated;
+        std::string path;
+        std::string data;
+    };
+
+    android::base::unique_fd fd(TEMP_FAILURE_RETRY(
+            open(gHistoryFile.c_str(), O_RDONLY | O_CLOEXEC)));
+    struct stat st;
+    if (!fd.ok() || fstat(fd, &st) || static_cast<size_t>(st.st_size) != historyFileSize)
+        return;
+
+    void *map = mmap(nullptr, historyFileSize, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+        return;
+    if (!validHeader(static_cast<HistoryHeader *>(map))) {
+        munmap(map, historyFileSize);
+        return;
+    }
+
+    const int64_t oldestNs = nowNs(CLOCK_REALTIME) - gHistoryMinutes * 60 * nsPerSec;
+    std::vector<Sample> samples;
+
+    for (uint32_t i = 0; i < historySlotCount; i++) {
+        const HistorySlot *slot = slotAt(map, i);
+        uint64_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (!seq || slot->realtimeNs < oldestNs)
+            continue;
+
+        Sample sample = {seq, slot->realtimeNs, slot->boottimeNs,
+                         (slot->flags & slotTruncated) != 0,
+                         std::string(slot->path, strnlen(slot->path, sizeof(slot->path))),
+                         std::string(slot->data, std::min<size_t>(slot->len, sizeof(slot->data)))};
+        /*
+         * Drop a sample that the recorder overwrote while it was copied. The
+         * fence keeps the copy from being read after the check.
+         */
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq)
+            continue;
+        samples.push_back(std::move(sample));
+    }
+    munmap(map, historyFileSize);
+
+    std::sort(samples.begin(), samples.end(),
+              [](const Sample &a, const Sample &b) { return a.seq < b.seq; });
+
+    dumpPrintf("\n------ Power history, last %d minutes (%s) ------\n", gHistoryMinutes,
+               gHistoryFile.c_str());
+    for (const auto &sample : samples) {
+        char date[32], stamp[48];
+        time_t seconds = sample.realtimeNs / nsPerSec;
+        struct tm tm;
+
+        strftime(date, sizeof(date), "%m-%d %H:%M:%S", localtime_r(&seconds, &tm));
+        snprintf(stamp, sizeof(stamp), "%s.%03" PRId64, date, sample.realtimeNs / nsPerMs % 1000);
+        dumpPrintf("%s boot+%" PRId64 ".%03" PRId64 "s %s%s\n", stamp,
+                   sample.boottimeNs / nsPerSec, sample.boottimeNs / nsPerMs % 1000,
+                   sample.path.c_str(), sample.truncated ? " (truncated)" : "");
+        dumpWrite(sample.data.data(), sample.data.size());
+        if (!sample.data.empty() && sample.data.back() != '\n')
+            dumpWrite("\n", 1);
+        dumpRecord(std::string(stamp) + " " + sample.path, sample.data, sample.path);
+    }
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/*
+ * Power state flight recorder. dump_power --record runs as a daemon that
+ * samples a set of nodes, by default every power supply uevent, into a ring
+ * of fixed size slots in a memory-mapped file. A node is stored when its
+ * content changes, and again once every keyframe interval so that quiet
+ * nodes stay in the ring. The history section of a dump then prints the last
+ * minutes of samples straight from the file, without reading any node.
+ */
+constexpr char defaultHistoryFile[] = "/data/vendor/dump_power/history";
+/* Reading every uevent wakes the fuel gauge bus, so an idle device is sampled rarely. */
+constexpr int defaultRecordIntervalMs = 30 * 1000;
+constexpr int defaultHistoryMinutes = 10;
+
+struct RecorderConfig {
+    std::string file = defaultHistoryFile;
+    // Nodes to sample; empty samples the uevent of every power supply.
+    std::vector<std::string> sources;
+    int intervalMs = defaultRecordIntervalMs;
+    int keyframeMs = 60 * 1000;
+};
+
+// Samples the configured nodes until the process is killed. Returns only on errors.
+int runRecorder(const RecorderConfig &config);
+
+// Sets the file and the window that the history section dumps.
+void setHistory(const std::string &file, int minutes);
+void dumpHistory();
@@ -0,0 +1,566 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_io.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "dump_power_output.h"
+#include "dump_power_profile.h"
+#include "dump_power_record.h"
+
+using std::chrono::steady_clock;
+
+namespace {
+
+constexpr size_t helperBufferSize = 32 * 1024;
+/*
+ * Logbuffer devices only copy out a kernel ring and never wait for data, so
+ * they are opened and read without a helper and may take the zero-copy path.
+ */
+constexpr const char *nonBlockingNodePrefixes[] = {"/dev/logbuffer_"};
+
+std::atomic<int> gNodeTimeoutMs(0);
+std::atomic<int> gSectionTimeoutMs(0);
+std::atomic<int> gTimeouts(0);
+steady_clock::time_point gDumpDeadline = steady_clock::time_point::max();
+int gRootFd = -1;
+
+thread_local steady_clock::time_point tSectionDeadline = steady_clock::time_point::max();
+
+/*
+ * State shared between a section thread and its node helper. The helper holds
+ * its own reference, so a helper that is abandoned in the middle of a blocked
+ * open or read never touches freed memory when the driver finally returns.
+ */
+struct HelperState {
+    enum Op { OPEN, READ };
+
+    std::mutex lock;
+    std::condition_variable cv;
+    bool pending = false;
+    bool done = false;
+    bool abandoned = false;
+
+    Op op = OPEN;
+    int dirFd = AT_FDCWD;
+    std::string path;
+    int fd = -1;
+    size_t len = 0;
+    ssize_t result = 0;
+    int error = 0;
+    char buffer[helperBufferSize];
+};
+
+void helperLoop(std::shared_ptr<HelperState> state) {
+    std::unique_lock<std::mutex> lock(state->lock);
+
+    while (true) {
+        state->cv.wait(lock, [&state] { return state->pending || state->abandoned; });
+        if (!state->pending)
+            return;
+
+        const HelperState::Op op = state->op;
+        const int dirFd = state->dirFd;
+        const int fd = state->fd;
+        const size_t len = state->len;
+        const std::string path = state->path;
+        lock.unlock();
+
+        ssize_t result;
+        if (op == HelperState::OPEN)
+            result = TEMP_FAILURE_RETRY(openat(dirFd, path.c_str(), O_RDONLY | O_CLOEXEC));
+        else
+            result = TEMP_FAILURE_RETRY(read(fd, state->buffer, len));
+        int error = errno;
+
+        lock.lock();
+        state->pending = false;
+        state->done = true;
+        state->result = result;
+        state->error = error;
+        state->cv.notify_all();
+
+        /* Nobody waits for the result any more, and the descriptor is ours to close. */
+        if (state->abandoned) {
+            if (op == HelperState::OPEN && result >= 0)
+                close(result);
+            else if (op == HelperState::READ)
+                close(fd);
+            return;
+        }
+    }
+}
+
+/* The node helper of the calling thread, started on first use. */
+class NodeHelper {
+  public:
+    ~NodeHelper() { abandon(); }
+
+    /*
+     * Runs |op| on the helper. Returns false if |deadline| passed first, in
+     * which case the helper is abandoned together with any descriptor it uses.
+     */
+    bool call(HelperState::Op op, int dirFd, const char *path, int fd, void *buf, size_t len,
+              steady_clock::time_point deadline, ssize_t *result) {
+        if (!mState) {
+            mState = std::make_shared<HelperState>();
+            std::thread(helperLoop, mState).detach();
+        }
+
+        std::unique_lock<std::mutex> lock(mState->lock);
+        mState->op = op;
+        mState->dirFd = dirFd;
+        if (path)
+            mState->path = path;
+        mState->fd = fd;
+        mState->len = std::min(len, helperBufferSize);
+        mState->done = false;
+        mState->pending = true;
+        mState->cv.notify_all();
+
+        if (!mState->cv.wait_until(lock, deadline, [this] { return mState->done; })) {
+            /*
+             * Still under the lock of the wait, so a helper finishing now sees
+             * that it was abandoned and closes the descriptor. One that finished
+             * already left it to us.
+             */
+            mState->abandoned = true;
+            mState->cv.notify_all();
+            if (mState->done) {
+                if (op == HelperState::OPEN && mState->result >= 0)
+                    close(mState->result);
+                else if (op == HelperState::READ)
+                    close(fd);
+            }
+            lock.unlock();
+            mState.reset();
+            return false;
+        }
+
+        *result = mState->result;
+        if (op == HelperState::READ && *result > 0)
+            memcpy(buf, mState->buffer, *result);
+        errno = mState->error;
+        return true;
+    }
+
+  private:
+    void abandon() {
+        if (!mState)
+            return;
+
+        std::unique_lock<std::mutex> lock(mState->lock);
+        mState->abandoned = true;
+        mState->cv.notify_all();
+        lock.unlock();
+        mState.reset();
+    }
+
+    std::shared_ptr<HelperState> mState;
+};
+
+thread_local NodeHelper tNodeHelper;
+
+bool deadlinesEnabled() {
+    return gNodeTimeoutMs.load(std::memory_order_relaxed) > 0;
+}
+
+bool nonBlockingNode(const std::string &path) {
+    for (const char *prefix : nonBlockingNodePrefixes) {
+        if (!path.compare(0, strlen(prefix), prefix))
+            return true;
+    }
+    return false;
+}
+
+steady_clock::time_point nodeDeadline() {
+    return std::min(steady_clock::now() +
+                            std::chrono::milliseconds(gNodeTimeoutMs.load(std::memory_order_relaxed)),
+                    tSectionDeadline);
+}
+
+}  // namespace
+
+void setNodeDeadlines(int nodeTimeoutMs, int sectionTimeoutMs) {
+    gNodeTimeoutMs = std::max(nodeTimeoutMs, 0);
+    gSectionTimeoutMs = std::max(sectionTimeoutMs, 0);
+}
+
+int nodeTimeoutCount() {
+    return gTimeouts;
+}
+
+void setDumpDeadline(steady_clock::time_point deadline) {
+    gDumpDeadline = deadline;
+}
+
+bool setNodeRoot(const char *root) {
+    if (gRootFd >= 0)
+        close(gRootFd);
+    gRootFd = TEMP_FAILURE_RETRY(open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    return gRootFd >= 0;
+}
+
+const char *rootedNodePath(int *dirFd, const char *path) {
+    if (gRootFd < 0 || *dirFd != AT_FDCWD || path[0] != '/')
+        return path;
+
+    *dirFd = gRootFd;
+    while (*path == '/')
+        path++;
+    return *path ? path : ".";
+}
+
+ScopedSectionDeadline::ScopedSectionDeadline() : mPrevious(tSectionDeadline) {
+    int timeoutMs = gSectionTimeoutMs;
+
+    tSectionDeadline = gDumpDeadline;
+    if (timeoutMs > 0)
+        tSectionDeadline = std::min(tSectionDeadline,
+                                    steady_clock::now() + std::chrono::milliseconds(timeoutMs));
+}
+
+ScopedSectionDeadline::~ScopedSectionDeadline() {
+    tSectionDeadline = mPrevious;
+}
+
+DumpNode::DumpNode(const char *path) : mPath(path), mProfiled(profileActive()) {
+    open(AT_FDCWD, path);
+}
+
+DumpNode::DumpNode(const NodeDir &dir, const char *name)
+    : mDir(&dir), mName(name), mProfiled(profileActive()) {
+    open(dir.fd(), name);
+}
+
+void DumpNode::open(int dirFd, const char *name) {
+    const PackMode pack = packMode();
+
+    mCapturing = pack == PackMode::CAPTURE;
+    if (mProfiled || mCapturing)
+        mStart = steady_clock::now();
+
+    if (pack == PackMode::REPLAY) {
+        if (!findPackNode(path(), &mReplay)) {
+            errno = ENOENT;
+        } else if (mReplay.openError == ETIMEDOUT) {
+            timedOut();
+        } else if (mReplay.openError) {
+            errno = mReplay.openError;
+        } else {
+            mReplaying = true;
+            if (mProfiled)
+                profileFileOpened();
+        }
+        return;
+    }
+
+    mGuarded = deadlinesEnabled() && !nonBlockingNode(mPath);
+    name = rootedNodePath(&dirFd, name);
+    if (!mGuarded) {
+        mFd.reset(TEMP_FAILURE_RETRY(openat(dirFd, name, O_RDONLY | O_CLOEXEC)));
+    } else {
+        steady_clock::time_point deadline = nodeDeadline();
+        ssize_t fd = -1;
+
+        if (deadline <= steady_clock::now() ||
+                !tNodeHelper.call(HelperState::OPEN, dirFd, name, -1, nullptr, 0, deadline, &fd)) {
+            mOpenError = ETIMEDOUT;
+            timedOut();
+            return;
+        }
+        mFd.reset(fd);
+    }
+
+    if (!mFd.ok())
+        mOpenError = errno;
+    if (mProfiled && mFd.ok())
+        profileFileOpened();
+    if (mFd.ok() && pack == PackMode::NONE && nodeCacheActive())
+        openCached();
+}
+
+void DumpNode::openCached() {
+    const std::string nodePath = path();
+    struct stat st;
+
+    if (!cachedNodePath(nodePath) || fstat(mFd, &st))
+        return;
+
+    mCacheKey = {nodePath, st.st_ino, st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec};
+    if (!lookupCachedNode(mCacheKey, &mCached)) {
+        mCaching = true;
+        return;
+    }
+
+    /* A hit is served like a replayed node, without reading the device again. */
+    mFd.reset();
+    mReplay = {mCached.data(), mCached.size(), 0, 0, std::chrono::nanoseconds(0)};
+    mReplaying = true;
+    mCacheHit = true;
+}
+
+DumpNode::~DumpNode() {
+    steady_clock::duration elapsed = steady_clock::now() - mStart;
+
+    if (mCapturing)
+        captureNode(path(), mCaptured, mOpenError, mReadError, elapsed,
+                    mReadEnded || mReadError || !mCaptured.empty());
+    if (mCaching && mReadEnded && !mReadError)
+        storeCachedNode(mCacheKey, mCaptured);
+    /* A replayed node costs what it cost when it was captured. */
+    if (mProfiled)
+        profileNodeDone(path().c_str(),
+                        mReplaying && !mCacheHit ? mReplay.elapsed : elapsed);
+}
+
+std::string DumpNode::path() const {
+    return mDir ? mDir->pathOf(mName) : mPath;
+}
+
+bool DumpNode::unguarded() const {
+    return !mGuarded && packMode() == PackMode::NONE && !mCaching && !mCacheHit;
+}
+
+ssize_t DumpNode::replay(void *buf, size_t len) {
+    len = std::min(len, mReplay.len - mReplayOffset);
+    if (!len && mReplay.readError) {
+        if (mReplay.readError == ETIMEDOUT) {
+            mReplaying = false;
+            timedOut();
+        }
+        errno = mReplay.readError;
+        return -1;
+    }
+
+    memcpy(buf, mReplay.data + mReplayOffset, len);
+    mReplayOffset += len;
+    if (len > 0)
+        profileBytesRead(len);
+    return len;
+}
+
+ssize_t DumpNode::read(void *buf, size_t len) {
+    ssize_t ret;
+
+    if (mReplaying)
+        return replay(buf, len);
+
+    if (!mFd.ok()) {
+        errno = EBADF;
+        return -1;
+    }
+
+    if (!mGuarded) {
+        ret = TEMP_FAILURE_RETRY(::read(mFd, buf, len));
+    } else {
+        steady_clock::time_point deadline = nodeDeadline();
+
+        if (deadline <= steady_clock::now()) {
+            mFd.reset();
+            mReadError = ETIMEDOUT;
+            timedOut();
+            return -1;
+        }
+        if (!tNodeHelper.call(HelperState::READ, AT_FDCWD, nullptr, mFd, buf, len, deadline,
+                              &ret)) {
+            /* The abandoned helper closes the descriptor once the read returns. */
+            (void)mFd.release();
+            mReadError = ETIMEDOUT;
+            timedOut();
+            return -1;
+        }
+    }
+
+    if (ret > 0)
+        profileBytesRead(ret);
+    if (mCapturing || mCaching) {
+        if (ret > 0)
+            mCaptured.append(static_cast<const char *>(buf), ret);
+        else if (ret < 0)
+            mReadError = errno;
+    }
+    mReadEnded |= ret == 0;
+    return ret;
+}
+
+bool DumpNode::readToString(std::string *content) {
+    char buffer[4096];
+    ssize_t len;
+
+    content->clear();
+    while ((len = read(buffer, sizeof(buffer))) > 0)
+        content->append(buffer, len);
+    return len == 0;
+}
+
+void DumpNode::addBytesRead(size_t len) {
+    profileBytesRead(len);
+}
+
+void DumpNode::timedOut() {
+    reportNodeTimeout(path());
+    errno = ETIMEDOUT;
+}
+
+steady_clock::time_point nodeAccessDeadline() {
+    return deadlinesEnabled() ? nodeDeadline() : steady_clock::time_point::max();
+}
+
+void reportNodeTimeout(const std::string &path) {
+    gTimeouts++;
+    profileNodeTimeout();
+    if (structuredOutput())
+        dumpMarkerRecord("TIMEOUT", path);
+    else
+        dumpPrintf("TIMEOUT: %s\n", path.c_str());
+}
+
+bool readNodeToString(const std::string &path, std::string *content, int *error) {
+    DumpNode node(path.c_str());
+    bool read = false;
+
+    if (!node.ok())
+        content->clear();
+    else
+        read = node.readToString(content);
+    /* Before ~DumpNode, which may capture the node, can change errno. */
+    *error = read ? 0 : errno;
+    return read;
+}
+
+bool readNodeToString(const std::string &path, std::string *content) {
+    int error;
+
+    if (readNodeToString(path, content, &error))
+        return true;
+    errno = error;
+    return false;
+}
+
+bool readNodeToString(const NodeDir &dir, const char *name, std::string *content) {
+    DumpNode node(dir, name);
+
+    if (!node.ok()) {
+        content->clear();
+        return false;
+    }
+    return node.readToString(content);
+}
+
+NodeDir::NodeDir(const char *path) : mPath(path) {
+    if (packMode() == PackMode::REPLAY) {
+        int openError = ENOENT;
+
+        mReplaying = findPackDir(mPath, &mEntries, &openError) && !openError;
+        if (mReplaying)
+            profileDirScan();
+        return;
+    }
+
+    int dirFd = AT_FDCWD;
+    const char *name = rootedNodePath(&dirFd, path);
+    mFd.reset(TEMP_FAILURE_RETRY(openat(dirFd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC)));
+    if (mFd.ok())
+        profileDirScan();
+
+    /* A capture takes every entry, whatever the sections go on to list. */
+    if (packMode() == PackMode::CAPTURE) {
+        int openError = mFd.ok() ? 0 : errno;
+        scan();
+        captureDir(mPath, mEntries, openError);
+    }
+}
+
+std::string NodeDir::pathOf(const char *name) const {
+    if (!mPath.empty() && mPath.back() == '/')
+        return mPath + name;
+    return mPath + "/" + name;
+}
+
+/* Layout of the records getdents64 returns; libc doesn't declare it everywhere. */
+struct NodeDirent {
+    uint64_t ino;
+    int64_t off;
+    unsigned short reclen;
+    unsigned char type;
+    char name[];
+};
+
+void NodeDir::scan() {
+    constexpr size_t chunkSize = 32 * 1024;
+    size_t used = 0;
+
+    mEntries.clear();
+    mScanned = true;
+    if (!mFd.ok())
+        return;
+
+    lseek(mFd, 0, SEEK_SET);
+    while (true) {
+        mBuffer.resize(used + chunkSize);
+        long len = syscall(SYS_getdents64, mFd.get(), &mBuffer[used], chunkSize);
+        if (len <= 0)
+            break;
+        used += len;
+    }
+    mBuffer.resize(used);
+
+    /* Only take the addresses once the buffer no longer moves. */
+    for (size_t offset = 0; offset < used;) {
+        const NodeDirent *entry = reinterpret_cast<const NodeDirent *>(&mBuffer[offset]);
+        offset += entry->reclen;
+
+        if (strcmp(entry->name, ".") && strcmp(entry->name, ".."))
+            mEntries.push_back(entry->name);
+    }
+}
+
+const std::vector<const char *> &NodeDir::list(Match match, const char *pattern) {
+    /*
+     * The directory is scanned once, so that the names of earlier lists stay
+     * valid. A replayed directory keeps the entries of its capture.
+     */
+    if (!mReplaying && !mScanned)
+        scan();
+
+    mNames.clear();
+    const size_t patternLen = pattern ? strlen(pattern) : 0;
+    for (const char *name : mEntries) {
+        if (match == PREFIX && strncmp(name, pattern, patternLen))
+            continue;
+        if (match == SUBSTRING && !strstr(name, pattern))
+            continue;
+        mNames.push_back(name);
+    }
+
+    std::sort(mNames.begin(), mNames.end(),
+              [](const char *a, const char *b) { return strcmp(a, b) < 0; });
+    return mNames;
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <android-base/unique_fd.h>
+
+#include "dump_power_nodecache.h"
+#include "dump_power_pack.h"
+
+class NodeDir;
+
+/*
+ * A sysfs, debugfs or logbuffer node opened for reading. Every node that
+ * dump_power reads goes through here so its cost can be accounted to the
+ * section that reads it.
+ *
+ * When node deadlines are enabled, the open and every read are carried out
+ * by a helper thread and the caller waits at most the node timeout, and
+ * never past the deadline of its section. A node that misses its deadline is
+ * reported as TIMEOUT in the section and behaves like a failed read; the
+ * helper keeps the descriptor and closes it once the driver returns.
+ *
+ * A capture records every node read through here, and a replay serves it
+ * from the pack, see dump_power_pack.h. Slow nodes are served from the node
+ * cache when it is on, see dump_power_nodecache.h.
+ */
+class DumpNode {
+  public:
+    explicit DumpNode(const char *path);
+    // Opens |name| relative to |dir|, without resolving the directory again.
+    DumpNode(const NodeDir &dir, const char *name);
+    ~DumpNode();
+
+    bool ok() const { return mFd.ok() || mReplaying; }
+    int fd() const { return mFd.get(); }
+    // Whether fd() may be read directly: the node has no deadline, and no pack or caching.
+    bool unguarded() const;
+
+    ssize_t read(void *buf, size_t len);
+    bool readToString(std::string *content);
+    // Accounts bytes that the caller consumed from fd() directly.
+    void addBytesRead(size_t len);
+
+  private:
+    void open(int dirFd, const char *name);
+    // Serves the node from the node cache, or arranges for its content to be stored there.
+    void openCached();
+    void timedOut();
+    std::string path() const;
+    ssize_t replay(void *buf, size_t len);
+
+    // Set for nodes opened by path; nodes of a NodeDir only build it when reported.
+    std::string mPath;
+    const NodeDir *mDir = nullptr;
+    const char *mName = nullptr;
+    android::base::unique_fd mFd;
+    std::chrono::steady_clock::time_point mStart;
+    bool mProfiled;
+    // Whether opens and reads go through the node helper, to be bounded by a deadline.
+    bool mGuarded = false;
+
+    bool mCapturing = false;
+    std::string mCaptured;
+    int mOpenError = 0;
+    int mReadError = 0;
+    bool mReplaying = false;
+    PackNode mReplay;
+    size_t mReplayOffset = 0;
+
+    // Set on a node cache miss, whose content is stored once it was read to the end.
+    bool mCaching = false;
+    bool mCacheHit = false;
+    bool mReadEnded = false;
+    NodeCacheKey mCacheKey;
+    std::string mCached;
+};
+
+/*
+ * Sets the per-node and per-section timeouts. A timeout of 0 disables it;
+ * node deadlines must be enabled for the section deadline to be enforced.
+ */
+void setNodeDeadlines(int nodeTimeoutMs, int sectionTimeoutMs);
+// Ends every section deadline at |deadline| at the latest. Must be set before sections start.
+void setDumpDeadline(std::chrono::steady_clock::time_point deadline);
+// Number of nodes that have been reported as TIMEOUT so far.
+int nodeTimeoutCount();
+
+// Starts the section deadline of the calling thread, if one is configured.
+class ScopedSectionDeadline {
+  public:
+    ScopedSectionDeadline();
+    ~ScopedSectionDeadline();
+
+  private:
+    std::chrono::steady_clock::time_point mPrevious;
+};
+
+/*
+ * Resolves absolute node paths below |root| instead of "/", so that a dump
+ * can run against a generated or copied node tree. Output keeps the device
+ * paths. Returns false if |root| can't be opened.
+ */
+bool setNodeRoot(const char *root);
+// Returns the path to open |path| with relative to |*dirFd|, which moves below the node root.
+const char *rootedNodePath(int *dirFd, const char *path);
+
+/*
+ * Deadline of a node access that starts now on the calling thread, or
+ * time_point::max() when node deadlines are disabled.
+ */
+std::chrono::steady_clock::time_point nodeAccessDeadline();
+// Reports |path| as TIMEOUT in the current section.
+void reportNodeTimeout(const std::string &path);
+
+/*
+ * A directory that is scanned for nodes. The entries are listed with
+ * getdents64 into a single buffer and filtered there, so listing costs no
+ * allocation per entry, and its nodes are opened relative to the directory
+ * descriptor rather than by rebuilding and resolving their full path.
+ */
+class NodeDir {
+  public:
+    enum Match {
+        ANY,
+        PREFIX,
+        SUBSTRING,
+    };
+
+    explicit NodeDir(const char *path);
+
+    bool ok() const { return mFd.ok() || mReplaying; }
+    int fd() const { return mFd.get(); }
+    const std::string &path() const { return mPath; }
+    // Full path of the entry |name|, for output.
+    std::string pathOf(const char *name) const;
+
+    /*
+     * Names of the entries matching |pattern|, sorted and without "." and
+     * "..". The directory is scanned by the first list(), and the names
+     * remain valid for the lifetime of the NodeDir; the vector is replaced
+     * by the next list().
+     */
+    const std::vector<const char *> &list(Match match = ANY, const char *pattern = nullptr);
+
+  private:
+    // Lists all entries into mEntries.
+    void scan();
+
+    std::string mPath;
+    android::base::unique_fd mFd;
+    bool mReplaying = false;
+    bool mScanned = false;
+    std::vector<char> mBuffer;
+    std::vector<const char *> mEntries;
+    std::vector<const char *> mNames;
+};
+
+// Drop-in replacement for android::base::ReadFileToString() on dump nodes.
+bool readNodeToString(const std::string &path, std::string *content);
+bool readNodeToString(const NodeDir &dir, const char *name, std::string *content);
+// As above, and sets |error| to the errno of a failed open or read, or to 0.
+bool readNodeToString(const std::string &path, std::string *content, int *error);
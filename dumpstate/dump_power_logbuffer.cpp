@@ -0,0 +1,321 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_logbuffer.h"
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <android-base/strings.h>
+#include <android-base/unique_fd.h>
+
+#include "dump_power_compress.h"
+#include "dump_power_io.h"
+#include "dump_power_output.h"
+#include "dump_power_record.h"
+
+namespace {
+
+constexpr char cursorMagic[] = "dump_power logbuffer cursor 2";
+constexpr char bootIdPath[] = "/proc/sys/kernel/random/boot_id";
+constexpr char logbufferPrefix[] = "/dev/logbuffer_";
+
+constexpr int64_t usPerSec = 1000000;
+constexpr int64_t noStamp = std::numeric_limits<int64_t>::min();
+
+int gWindowSeconds = 0;
+bool gCursorActive = false;
+std::string gCursorPath;
+std::string gBootId;
+
+/* Cursors of the previous dump by logbuffer path. Read only once loaded. */
+std::unordered_map<std::string, LogbufferCursor> gBaseline;
+
+std::mutex gCursorLock;
+std::map<std::string, LogbufferCursor> gCursors;
+
+int64_t monotonicUs() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * usPerSec + ts.tv_nsec / 1000;
+}
+
+/* Loads the cursors of |path| if they were saved on this boot. */
+void loadBaseline(const std::string &path) {
+    std::string content;
+
+    if (!android::base::ReadFileToString(path, &content))
+        return;
+
+    std::vector<std::string> lines = android::base::Split(content, "\n");
+    if (lines.size() < 2 || lines[0] != cursorMagic || lines[1] != "boot_id\t" + gBootId)
+        return;
+
+    for (size_t i = 2; i < lines.size(); i++) {
+        /* <stamp us>\t<lines>\t<line hash>\t<path> */
+        std::vector<std::string> fields = android::base::Split(lines[i], "\t");
+        if (fields.size() != 4)
+            continue;
+        LogbufferCursor cursor;
+        cursor.stampUs = strtoll(fields[0].c_str(), nullptr, 10);
+        cursor.lines = strtoul(fields[1].c_str(), nullptr, 10);
+        cursor.lineHash = strtoull(fields[2].c_str(), nullptr, 16);
+        gBaseline[fields[3]] = cursor;
+    }
+}
+
+/* The cursor |file| was left at by the previous dump, or null. */
+const LogbufferCursor *baselineCursor(const char *file) {
+    if (!gCursorActive)
+        return nullptr;
+    auto it = gBaseline.find(file);
+    return it != gBaseline.end() && it->second.stampUs >= 0 ? &it->second : nullptr;
+}
+
+/* First stamp of the time window, or noStamp without one. */
+int64_t windowSince() {
+    if (gWindowSeconds <= 0)
+        return noStamp;
+    return std::max<int64_t>(0, monotonicUs() - gWindowSeconds * usPerSec);
+}
+
+/* FNV-1a, which stays the same across processes and builds, unlike std::hash. */
+uint64_t hashLine(std::string_view line) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (unsigned char c : line) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/*
+ * Moves |start|, the first line stamped like |after|, past the lines |after|
+ * saw. If they don't match, the buffer changed under the cursor and nothing
+ * is skipped, so that lines may be repeated but never lost.
+ */
+size_t skipSeenLines(std::string_view content, size_t start, const LogbufferCursor &after) {
+    uint32_t seen = 0;
+    bool matched = false;
+
+    for (size_t lineStart = start; lineStart < content.size();) {
+        const size_t newline = content.find('\n', lineStart);
+        const size_t lineEnd = newline == std::string_view::npos ? content.size() : newline;
+        const std::string_view line = content.substr(lineStart, lineEnd - lineStart);
+        int64_t stamp;
+
+        if (parseLogbufferStamp(line, &stamp)) {
+            /* The first line after the seen ones, past their unstamped continuations. */
+            if (matched)
+                return lineStart;
+            if (stamp != after.stampUs)
+                return start;
+            if (++seen == after.lines) {
+                if (hashLine(line) != after.lineHash)
+                    return start;
+                matched = true;
+            }
+        }
+        lineStart = lineEnd + 1;
+    }
+    return matched ? content.size() : start;
+}
+
+}  // namespace
+
+void setLogbufferWindow(int seconds) {
+    gWindowSeconds = seconds;
+}
+
+void setLogbufferCursor(const char *path) {
+    gCursorActive = true;
+    gCursorPath = path;
+    if (android::base::ReadFileToString(bootIdPath, &gBootId))
+        gBootId = android::base::Trim(gBootId);
+    loadBaseline(gCursorPath);
+}
+
+bool logbufferTailed(const char *file) {
+    return (gWindowSeconds > 0 || gCursorActive) &&
+            !strncmp(file, logbufferPrefix, strlen(logbufferPrefix));
+}
+
+bool parseLogbufferStamp(std::string_view line, int64_t *stampUs) {
+    size_t i = 0;
+    int64_t seconds = 0;
+    int64_t micros = 0;
+    int digits;
+
+    if (line.empty() || line[i++] != '[')
+        return false;
+    while (i < line.size() && line[i] == ' ')
+        i++;
+
+    /* Seconds are bounded so that the stamp in microseconds can't overflow. */
+    for (digits = 0; i < line.size() && isdigit(static_cast<unsigned char>(line[i])); digits++) {
+        if (digits == 12)
+            return false;
+        seconds = seconds * 10 + (line[i++] - '0');
+    }
+    if (!digits || i >= line.size() || line[i++] != '.')
+        return false;
+
+    for (digits = 0; i < line.size() && isdigit(static_cast<unsigned char>(line[i])); digits++) {
+        if (digits == 6)
+            return false;
+        micros = micros * 10 + (line[i++] - '0');
+    }
+    if (!digits || i >= line.size() || line[i] != ']')
+        return false;
+    for (; digits < 6; digits++)
+        micros *= 10;
+
+    *stampUs = seconds * usPerSec + micros;
+    return true;
+}
+
+size_t logbufferTailStart(std::string_view content, int64_t sinceUs,
+                          const LogbufferCursor *after, LogbufferCursor *newest) {
+    const char *data = content.data();
+    size_t lineEnd = content.size();
+    size_t start = content.size();
+    bool stamped = false;
+
+    /* The lines stamped like the cursor are found, and those it saw skipped below. */
+    if (after)
+        sinceUs = std::max(sinceUs, after->stampUs);
+    *newest = LogbufferCursor();
+    if (lineEnd > 0 && data[lineEnd - 1] == '\n')
+        lineEnd--;
+
+    /* Line by line from the end; memrchr() finds each line break a word at a time. */
+    for (;;) {
+        const char *newline = static_cast<const char *>(memrchr(data, '\n', lineEnd));
+        const size_t lineStart = newline ? newline - data + 1 : 0;
+        int64_t stamp;
+
+        const std::string_view line = content.substr(lineStart, lineEnd - lineStart);
+        if (parseLogbufferStamp(line, &stamp)) {
+            if (!stamped) {
+                stamped = true;
+                newest->stampUs = stamp;
+                newest->lineHash = hashLine(line);
+            }
+            /* Past the lines of the newest stamp, a full dump has all it needs. */
+            if (stamp == newest->stampUs)
+                newest->lines++;
+            else if (stamp < sinceUs || sinceUs == noStamp)
+                break;
+            if (stamp >= sinceUs)
+                start = lineStart;
+        }
+        if (!newline)
+            break;
+        lineEnd = lineStart - 1;
+    }
+
+    /* A buffer without any stamp can't be cut and is dumped whole. */
+    if (!stamped || sinceUs == noStamp)
+        return 0;
+    return after ? skipSeenLines(content, start, *after) : start;
+}
+
+void dumpLogbufferTail(const char *title, const char *file) {
+    const LogbufferCursor *after = baselineCursor(file);
+    const int64_t window = windowSince();
+    const int64_t since = after ? std::max(window, after->stampUs) : window;
+    std::string content;
+
+    DumpNode node(file);
+    if (!node.ok() || (!node.readToString(&content) && content.empty())) {
+        if (structuredOutput())
+            dumpFileValueRecord(title, file, nullptr);
+        else
+            dumpPrintf("------ %s (%s) ------\n", title, file);
+        return;
+    }
+
+    LogbufferCursor newest;
+    const size_t start = logbufferTailStart(content, window, after, &newest);
+    if (gCursorActive && newest.stampUs >= 0) {
+        std::lock_guard<std::mutex> lock(gCursorLock);
+        gCursors[file] = newest;
+    }
+
+    if (structuredOutput()) {
+        content.erase(0, start);
+        dumpFileValueRecord(title, file, &content);
+        return;
+    }
+
+    if (since == noStamp)
+        dumpPrintf("------ %s (%s) ------\n", title, file);
+    else
+        dumpPrintf("------ %s (%s): since [%5" PRId64 ".%06" PRId64 "] ------\n", title, file,
+                   since / usPerSec, since % usPerSec);
+    if (compressionActive()) {
+        CompressedBlock block;
+        block.append(content.data() + start, content.size() - start);
+        block.finish();
+    } else {
+        dumpWrite(content.data() + start, content.size() - start);
+    }
+    dumpWrite("\n", 1);
+}
+
+bool saveLogbufferCursor() {
+    std::string content = std::string(cursorMagic) + "\n";
+    content += "boot_id\t" + gBootId + "\n";
+    {
+        std::lock_guard<std::mutex> lock(gCursorLock);
+        /* Logbuffers this dump didn't read, or found without stamps, keep their cursor. */
+        for (const auto &[path, cursor] : gBaseline)
+            gCursors.emplace(path, cursor);
+        for (const auto &[path, cursor] : gCursors)
+            content += android::base::StringPrintf("%" PRId64 "\t%" PRIu32 "\t%016" PRIx64 "\t%s\n",
+                                                   cursor.stampUs, cursor.lines, cursor.lineHash,
+                                                   path.c_str());
+    }
+
+    /* Written aside and renamed, so a dump killed halfway never leaves torn cursors. */
+    std::string tmpPath = gCursorPath + ".tmp";
+    android::base::unique_fd fd(TEMP_FAILURE_RETRY(
+            open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600)));
+    if (!fd.ok())
+        return false;
+    if (!android::base::WriteStringToFd(content, fd) || fsync(fd)) {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return rename(tmpPath.c_str(), gCursorPath.c_str()) == 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string_view>
+
+/*
+ * Logbuffer tailing. The /dev/logbuffer_* nodes hold kernel lines stamped
+ * "[seconds.micros]" with the monotonic clock, and are normally dumped whole.
+ * With a time window only the lines stamped within the last seconds are
+ * dumped; with a cursor only the lines added after the newest line that the
+ * previous cursor dump of this boot saw. Both may be combined.
+ *
+ * A logbuffer can't be seeked, so neither a window nor a cursor saves any
+ * reading: every buffer is still read whole on every dump. They only cut what
+ * is written, and the tail is found from the end of the buffer backwards, so
+ * parsing stamps costs what the lines dumped cost rather than the whole buffer.
+ */
+constexpr char defaultLogbufferCursor[] = "/data/vendor/dump_power/logbuffer_cursor";
+
+// Only dumps the logbuffer lines stamped within the last |seconds|.
+void setLogbufferWindow(int seconds);
+// Only dumps the logbuffer lines added since the cursors in |path|, if they are of this boot.
+void setLogbufferCursor(const char *path);
+// Whether |file| is dumped through dumpLogbufferTail().
+bool logbufferTailed(const char *file);
+
+// dumpFileContent() of a logbuffer in tail mode.
+void dumpLogbufferTail(const char *title, const char *file);
+// Replaces the cursor file with the newest line of every logbuffer dumped. Only called once the
+// dump output is known to have been written, so that no line is skipped unseen.
+bool saveLogbufferCursor();
+
+/*
+ * Where a cursor dump stopped. Stamps have microsecond resolution, so lines
+ * added later may carry the newest stamp too; the lines with that stamp are
+ * counted, and the last of them is recognized by its hash.
+ */
+struct LogbufferCursor {
+    // The newest stamp, or -1 for a buffer without stamps.
+    int64_t stampUs = -1;
+    uint32_t lines = 0;
+    uint64_t lineHash = 0;
+};
+
+// Parses the "[seconds.micros]" stamp at the start of |line|, in microseconds.
+bool parseLogbufferStamp(std::string_view line, int64_t *stampUs);
+/*
+ * Offset of the first line of |content| stamped at or after |sinceUs| that
+ * comes after the lines |after| saw, if set. Unstamped lines follow the
+ * stamped line before them. |newest| is the cursor of |content|.
+ */
+size_t logbufferTailStart(std::string_view content, int64_t sinceUs,
+                          const LogbufferCursor *after, LogbufferCursor *newest);
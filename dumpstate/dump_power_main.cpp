@@ -0,0 +1,465 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <android-base/strings.h>
+
+#include "dump_power_compress.h"
+#include "dump_power_cpuidle.h"
+#include "dump_power_delta.h"
+#include "dump_power_history.h"
+#include "dump_power_io.h"
+#include "dump_power_logbuffer.h"
+#include "dump_power_nodecache.h"
+#include "dump_power_output.h"
+#include "dump_power_pack.h"
+#include "dump_power_profile.h"
+#include "dump_power_record.h"
+#include "dump_power_runner.h"
+#include "dump_power_sections.h"
+#include "dump_power_service.h"
+
+/* Sections mostly block on sysfs, debugfs and logbuffer reads, not on the CPU. */
+const int defaultJobs = 4;
+/*
+ * dumpstate runs dump_power without arguments, so a node that hangs must not
+ * hold up the dump by default: nodes, sections and the whole dump are bounded.
+ * Logbuffers never block and keep the zero-copy path under the deadlines.
+ */
+const int defaultNodeTimeoutMs = 1000;
+const int defaultSectionTimeoutMs = 5000;
+const int defaultBudgetMs = 30 * 1000;
+
+/*
+ * Whether the section |name| is picked by one of |selectors|, either by its
+ * name or by the group it starts with, so "mitigation" also picks
+ * mitigation_stats and mitigation_dirs.
+ */
+bool sectionMatches(const char *name, const std::vector<std::string> &selectors) {
+    for (const auto &selector : selectors) {
+        if (selector == name ||
+                (android::base::StartsWith(name, selector) && name[selector.size()] == '_'))
+            return true;
+    }
+    return false;
+}
+
+/* Splits a comma separated selector list. Returns false if a selector matches no section. */
+bool parseSelectors(const char *arg, std::vector<std::string> *selectors) {
+    for (const auto &selector : android::base::Split(arg, ",")) {
+        if (selector.empty())
+            continue;
+
+        bool known = false;
+        for (size_t i = 0; i < dumpSectionCount; i++)
+            known |= sectionMatches(dumpSections[i].name, {selector});
+        if (!known) {
+            fprintf(stderr, "Unknown section %s\n", selector.c_str());
+            return false;
+        }
+        selectors->push_back(selector);
+    }
+    return true;
+}
+
+void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-j|--jobs N] [--profile] [--node-timeout-ms MS]"
+            " [--section-timeout-ms MS] [--format text|json] [--delta[=SNAPSHOT]]"
+            " [--sections LIST] [--exclude LIST] [--budget-ms MS] [--history FILE]"
+            " [--history-minutes N] [--capture PACK | --replay PACK] [--root DIR]"
+            " [--logbuffer-window-s S] [--logbuffer-cursor[=FILE]] [--compress]"
+            " [--cpuidle-baseline FILE] [--node-cache[=FILE]] [--node-cache-ttl-ms MS]"
+            " [--local]\n",
+            name);
+    fprintf(stderr, "       %s --record [--history FILE] [--interval-ms MS]"
+            " [--record-sources LIST]\n", name);
+    fprintf(stderr, "       %s --serve[=SOCKET] [--root DIR]\n", name);
+    fprintf(stderr, "  -j, --jobs N    run up to N sections in parallel (default %d, 1 runs"
+            " them sequentially)\n", defaultJobs);
+    fprintf(stderr, "  --profile       append a per-section cost table to the dump\n");
+    fprintf(stderr, "  --node-timeout-ms MS\n"
+            "                  give up on a single node after MS ms (default %d, 0 disables"
+            " node and section deadlines)\n", defaultNodeTimeoutMs);
+    fprintf(stderr, "  --section-timeout-ms MS\n"
+            "                  skip the remaining nodes of a section after MS ms, with a node"
+            " timeout\n                  set (default %d, 0 disables)\n", defaultSectionTimeoutMs);
+    fprintf(stderr, "  --format FORMAT text (default) or json, one typed record per line\n");
+    fprintf(stderr, "  --delta[=SNAPSHOT]\n"
+            "                  only write what changed since the last delta dump of this boot,"
+            " and\n                  keep the snapshot in SNAPSHOT (default %s)\n",
+            defaultDeltaSnapshot);
+    fprintf(stderr, "  --sections LIST only dump the comma separated sections or section groups\n");
+    fprintf(stderr, "  --exclude LIST  skip the comma separated sections or section groups\n");
+    fprintf(stderr, "  --budget-ms MS  skip sections that would start after MS ms, starting the"
+            " most\n                  important ones first (default %d, 0 disables)\n",
+            defaultBudgetMs);
+    fprintf(stderr, "  --history FILE  flight recorder ring file (default %s)\n",
+            defaultHistoryFile);
+    fprintf(stderr, "  --history-minutes N\n"
+            "                  dump the recorded samples of the last N minutes (default %d)\n",
+            defaultHistoryMinutes);
+    fprintf(stderr, "  --capture PACK  record every node and directory the dump reads into PACK\n");
+    fprintf(stderr, "  --replay PACK   read the nodes and directories from PACK instead of the"
+            " device\n");
+    fprintf(stderr, "  --root DIR      read the nodes below DIR instead of /, such as a tree"
+            " made by\n                  dump_power_tree\n");
+    fprintf(stderr, "  --logbuffer-window-s S\n"
+            "                  only dump the logbuffer lines of the last S seconds\n");
+    fprintf(stderr, "  --logbuffer-cursor[=FILE]\n"
+            "                  only dump the logbuffer lines added since the last cursor dump"
+            " of\n                  this boot, and keep the cursors in FILE (default %s)\n",
+            defaultLogbufferCursor);
+    fprintf(stderr, "  --compress      write logbuffers and register dumps as base64 LZ4 blocks\n");
+    fprintf(stderr, "  --cpuidle-baseline FILE\n"
+            "                  summarize the cpuidle histograms against the counts kept in FILE"
+            " by\n                  the previous dump of this boot (default %s, none with"
+            " --root\n                  or --replay)\n", defaultCpuidleBaseline);
+    fprintf(stderr, "  --node-cache[=FILE]\n"
+            "                  serve register dumps read by a recent dump from the cache"
+            " shared in\n                  FILE, and keep them there"
+            " (default %s)\n", defaultNodeCache);
+    fprintf(stderr, "  --node-cache-ttl-ms MS\n"
+            "                  serve cached nodes up to MS ms old (default %d)\n",
+            defaultNodeCacheTtlMs);
+    fprintf(stderr, "  --local         dump in this process even if the dump_power service runs\n");
+    fprintf(stderr, "  --serve[=SOCKET]\n"
+            "                  run as service, answering dumps on SOCKET (default the init"
+            " socket\n                  %s) with the device topology kept probed\n",
+            defaultServiceSocket);
+    fprintf(stderr, "  --record        run as flight recorder, sampling nodes into the history"
+            " file\n");
+    fprintf(stderr, "  --interval-ms MS\n"
+            "                  sample every MS ms while recording (default %d)\n",
+            defaultRecordIntervalMs);
+    fprintf(stderr, "  --record-sources LIST\n"
+            "                  comma separated nodes to record (default every power supply"
+            " uevent)\n");
+    fprintf(stderr, "Sections:");
+    for (size_t i = 0; i < dumpSectionCount; i++)
+        fprintf(stderr, " %s", dumpSections[i].name);
+    fprintf(stderr, "\n");
+}
+
+/* Whether a dump runs in this process rather than in the resident service. */
+bool dumpsLocally(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        /* Paths of test packs and trees are relative to the caller, not to the service. */
+        for (const char *option : {"--local", "--serve", "--record", "--capture", "--replay",
+                                   "--root", "--help", "-h"}) {
+            if (android::base::StartsWith(argv[i], option))
+                return true;
+        }
+
+        /*
+         * So are the state files a dump keeps for the caller, which the service would
+         * also write with its own uid. Only their default paths are shared with it.
+         */
+        for (const char *option : {"--delta=", "--logbuffer-cursor=", "--node-cache=",
+                                   "--history", "--cpuidle-baseline"}) {
+            if (android::base::StartsWith(argv[i], option) &&
+                    !android::base::StartsWith(argv[i], "--history-minutes"))
+                return true;
+        }
+    }
+    return false;
+}
+
+int dumpMain(int argc, char **argv) {
+    const struct option options[] = {
+            {"jobs", required_argument, nullptr, 'j'},
+            {"profile", no_argument, nullptr, 'p'},
+            {"node-timeout-ms", required_argument, nullptr, 'n'},
+            {"section-timeout-ms", required_argument, nullptr, 's'},
+            {"format", required_argument, nullptr, 'f'},
+            {"delta", optional_argument, nullptr, 'd'},
+            {"sections", required_argument, nullptr, 'S'},
+            {"exclude", required_argument, nullptr, 'x'},
+            {"budget-ms", required_argument, nullptr, 'b'},
+            {"history", required_argument, nullptr, 'H'},
+            {"history-minutes", required_argument, nullptr, 'm'},
+            {"capture", required_argument, nullptr, 'C'},
+            {"replay", required_argument, nullptr, 'P'},
+            {"root", required_argument, nullptr, 'T'},
+            {"logbuffer-window-s", required_argument, nullptr, 'w'},
+            {"logbuffer-cursor", optional_argument, nullptr, 'c'},
+            {"compress", no_argument, nullptr, 'z'},
+            {"cpuidle-baseline", required_argument, nullptr, 'I'},
+            {"node-cache", optional_argument, nullptr, 'N'},
+            {"node-cache-ttl-ms", required_argument, nullptr, 'e'},
+            {"record", no_argument, nullptr, 'R'},
+            {"interval-ms", required_argument, nullptr, 'i'},
+            {"record-sources", required_argument, nullptr, 'r'},
+            {"serve", optional_argument, nullptr, 'V'},
+            {"local", no_argument, nullptr, 'L'},
+            {"help", no_argument, nullptr, 'h'},
+            {nullptr, 0, nullptr, 0},
+    };
+    int jobs = defaultJobs;
+    bool profile = false;
+    int nodeTimeoutMs = defaultNodeTimeoutMs;
+    int sectionTimeoutMs = defaultSectionTimeoutMs;
+    const char *deltaSnapshot = nullptr;
+    std::vector<std::string> selected;
+    std::vector<std::string> excluded;
+    int budgetMs = defaultBudgetMs;
+    bool record = false;
+    RecorderConfig recorder;
+    int historyMinutes = defaultHistoryMinutes;
+    const char *capturePack = nullptr;
+    const char *replayPack = nullptr;
+    const char *root = nullptr;
+    int logbufferWindowS = 0;
+    const char *logbufferCursor = nullptr;
+    const char *cpuidleBaseline = nullptr;
+    const char *nodeCache = nullptr;
+    int nodeCacheTtlMs = defaultNodeCacheTtlMs;
+    bool serve = false;
+    const char *serviceSocket = nullptr;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "j:h", options, nullptr)) != -1) {
+        switch (opt) {
+        case 'j':
+            jobs = atoi(optarg);
+            if (jobs < 1) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'p':
+            profile = true;
+            break;
+        case 'n':
+            nodeTimeoutMs = atoi(optarg);
+            if (nodeTimeoutMs < 0) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 's':
+            sectionTimeoutMs = atoi(optarg);
+            if (sectionTimeoutMs < 0) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'f':
+            if (!strcmp(optarg, "json")) {
+                setOutputFormat(OutputFormat::JSON);
+            } else if (strcmp(optarg, "text")) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'd':
+            deltaSnapshot = optarg ? optarg : defaultDeltaSnapshot;
+            break;
+        case 'S':
+            if (!parseSelectors(optarg, &selected)) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'x':
+            if (!parseSelectors(optarg, &excluded)) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'b':
+            budgetMs = atoi(optarg);
+            if (budgetMs < 0) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'H':
+            recorder.file = optarg;
+            break;
+        case 'm':
+            historyMinutes = atoi(optarg);
+            if (historyMinutes < 1) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'C':
+            capturePack = optarg;
+            break;
+        case 'P':
+            replayPack = optarg;
+            break;
+        case 'T':
+            root = optarg;
+            break;
+        case 'w':
+            logbufferWindowS = atoi(optarg);
+            if (logbufferWindowS < 1) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'c':
+            logbufferCursor = optarg ? optarg : defaultLogbufferCursor;
+            break;
+        case 'z':
+            setCompression(true);
+            break;
+        case 'I':
+            cpuidleBaseline = optarg;
+            break;
+        case 'N':
+            nodeCache = optarg ? optarg : defaultNodeCache;
+            break;
+        case 'e':
+            nodeCacheTtlMs = atoi(optarg);
+            if (nodeCacheTtlMs < 1) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'R':
+            record = true;
+            break;
+        case 'i':
+            recorder.intervalMs = atoi(optarg);
+            if (recorder.intervalMs < 1) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'r':
+            for (const auto &source : android::base::Split(optarg, ",")) {
+                if (!source.empty())
+                    recorder.sources.push_back(source);
+            }
+            break;
+        case 'V':
+            serve = true;
+            serviceSocket = optarg;
+            break;
+        case 'L':
+            break;
+        case 'h':
+            usage(argv[0]);
+            return EXIT_SUCCESS;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (capturePack && replayPack) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (root && !setNodeRoot(root)) {
+        fprintf(stderr, "Failed to open the node root %s\n", root);
+        return EXIT_FAILURE;
+    }
+    if (capturePack)
+        startCapture(capturePack);
+    if (replayPack && !startReplay(replayPack)) {
+        fprintf(stderr, "Failed to load the pack %s\n", replayPack);
+        return EXIT_FAILURE;
+    }
+
+    if (serve)
+        return runService(serviceSocket, dumpMain);
+    if (record) {
+        setNodeDeadlines(nodeTimeoutMs, 0);
+        return runRecorder(recorder);
+    }
+    setHistory(recorder.file, historyMinutes);
+
+    std::vector<DumpSection> sections;
+    for (size_t i = 0; i < dumpSectionCount; i++) {
+        if ((selected.empty() || sectionMatches(dumpSections[i].name, selected)) &&
+                !sectionMatches(dumpSections[i].name, excluded))
+            sections.push_back(dumpSections[i]);
+    }
+
+    setNodeDeadlines(nodeTimeoutMs, sectionTimeoutMs);
+    auto budgetEnd = std::chrono::steady_clock::time_point::max();
+    if (budgetMs > 0) {
+        budgetEnd = std::chrono::steady_clock::now() + std::chrono::milliseconds(budgetMs);
+        setDumpDeadline(budgetEnd);
+    }
+    if (deltaSnapshot) {
+        setDeltaSnapshot(deltaSnapshot);
+        printDeltaHeader();
+    }
+    if (logbufferWindowS > 0)
+        setLogbufferWindow(logbufferWindowS);
+    if (logbufferCursor)
+        setLogbufferCursor(logbufferCursor);
+    /* A tree or pack must not replace the baseline of the device itself. */
+    if (!cpuidleBaseline && !root && !replayPack)
+        cpuidleBaseline = defaultCpuidleBaseline;
+    if (cpuidleBaseline)
+        setCpuidleBaseline(cpuidleBaseline);
+    if (nodeCache && !startNodeCache(nodeCache, nodeCacheTtlMs))
+        fprintf(stderr, "Failed to map the node cache %s, reading every node\n", nodeCache);
+
+    std::vector<SectionProfile> profiles;
+    SectionRunner runner(sections.data(), sections.size(), jobs, profile ? &profiles : nullptr);
+    runner.setBudget(budgetEnd);
+    runner.run();
+
+    if (profile)
+        printProfileTable(profiles);
+    if (capturePack && !finishCapture())
+        fprintf(stderr, "Failed to write the pack %s\n", capturePack);
+    if (deltaSnapshot && !saveDeltaSnapshot())
+        fprintf(stderr, "Failed to save the delta snapshot %s\n", deltaSnapshot);
+    /* Lines that never reached the reader must be dumped again by the next cursor dump. */
+    if (logbufferCursor && dumpOutputFailed())
+        fprintf(stderr, "Output failed, keeping the logbuffer cursors %s\n", logbufferCursor);
+    else if (logbufferCursor && !saveLogbufferCursor())
+        fprintf(stderr, "Failed to save the logbuffer cursors %s\n", logbufferCursor);
+    if (cpuidleBaseline && !saveCpuidleBaseline())
+        fprintf(stderr, "Failed to save the cpuidle baseline %s\n", cpuidleBaseline);
+
+    /*
+     * Helpers abandoned on a stuck node may still be blocked in the driver. Close stdout so the
+     * reader sees the end of the dump now, and skip the exit-time cleanup they could race with.
+     */
+    if (nodeTimeoutCount() > 0) {
+        endServiceReply(EXIT_SUCCESS);
+        fflush(stdout);
+        close(STDOUT_FILENO);
+        _exit(EXIT_SUCCESS);
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+    /* A running service already has the topology probed; dump here only if none answers. */
+    std::vector<std::string> args(argv + 1, argv + argc);
+    int status;
+    if (!dumpsLocally(argc, argv) && requestServiceDump(defaultServiceSocket, args, &status))
+        return status;
+    return dumpMain(argc, argv);
+}
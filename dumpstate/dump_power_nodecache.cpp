@@ -0,0 +1,245 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_nodecache.h"
+
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+#include <android-base/file.h>
+#include <android-base/strings.h>
+#include <android-base/unique_fd.h>
+
+namespace {
+
+constexpr char cacheMagic[16] = "dp node cache 1";
+constexpr char bootIdPath[] = "/proc/sys/kernel/random/boot_id";
+constexpr char registersDumpSuffix[] = "/registers_dump";
+constexpr const char *debugfsPrefixes[] = {"/sys/kernel/debug/", "/d/"};
+/* Debugfs nodes below the prefixes which read registers and leave the chip as it was. */
+constexpr const char *debugfsRegisterNodes[] = {
+        "eusb_repeater/registers",
+        "*maxfg*/registers",
+        "*maxfg*/nv_registers",
+        "*maxfg*/fg_model",
+        "*max77779fg*/registers",
+        "*max77779fg*/debug_registers",
+        "*max77779fg*/fg_model",
+};
+
+constexpr size_t entryCount = 256;
+constexpr size_t entryPathSize = 192;
+constexpr size_t probeLength = 8;
+constexpr size_t dataSize = 4 * 1024 * 1024;
+/* Larger nodes would push most of the others out of the data ring. */
+constexpr size_t maxNodeSize = dataSize / 8;
+
+constexpr int64_t nsPerSec = 1000000000;
+constexpr int64_t nsPerMs = 1000000;
+
+struct CacheEntry {
+    char path[entryPathSize];
+    uint64_t inode;
+    int64_t mtimeNs;
+    // CLOCK_BOOTTIME of the store, 0 for an unused entry.
+    int64_t storedNs;
+    // Position of the content in the data stream, see CacheHeader::head.
+    uint64_t offset;
+    uint64_t len;
+};
+
+/*
+ * The content of the entries is appended to a data ring behind the header. head
+ * is the stream position of the next write and only grows, so the content of
+ * an entry is intact while it is less than dataSize behind head.
+ */
+struct CacheHeader {
+    char magic[sizeof(cacheMagic)];
+    char bootId[48];
+    uint64_t head;
+    CacheEntry entries[entryCount];
+};
+
+constexpr size_t cacheFileSize = sizeof(CacheHeader) + dataSize;
+
+std::atomic<bool> gActive(false);
+int64_t gTtlNs = 0;
+android::base::unique_fd gFd;
+CacheHeader *gHeader = nullptr;
+char *gData = nullptr;
+
+/*
+ * flock() excludes other runs, but not the other sections of this run, which
+ * share the open file description; they are excluded by the mutex.
+ */
+std::mutex gLock;
+
+class CacheLock {
+  public:
+    explicit CacheLock(int operation) : mGuard(gLock) { flock(gFd, operation); }
+    ~CacheLock() { flock(gFd, LOCK_UN); }
+
+  private:
+    std::lock_guard<std::mutex> mGuard;
+};
+
+int64_t boottimeNs() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return ts.tv_sec * nsPerSec + ts.tv_nsec;
+}
+
+size_t firstSlot(const std::string &path) {
+    return std::hash<std::string>()(path) % entryCount;
+}
+
+bool matches(const CacheEntry &entry, const std::string &path) {
+    return entry.storedNs && !strncmp(entry.path, path.c_str(), sizeof(entry.path));
+}
+
+/* Whether |entry| may still be served at |now|. */
+bool fresh(const CacheEntry &entry, int64_t now) {
+    return entry.storedNs && now - entry.storedNs <= gTtlNs &&
+            entry.offset + dataSize >= gHeader->head;
+}
+
+}  // namespace
+
+bool startNodeCache(const char *path, int ttlMs) {
+    gFd.reset(TEMP_FAILURE_RETRY(open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600)));
+    if (!gFd.ok())
+        return false;
+
+    struct stat st;
+    if (fstat(gFd, &st) || (static_cast<size_t>(st.st_size) != cacheFileSize &&
+            ftruncate(gFd, cacheFileSize)))
+        return false;
+
+    void *map = mmap(nullptr, cacheFileSize, PROT_READ | PROT_WRITE, MAP_SHARED, gFd, 0);
+    if (map == MAP_FAILED)
+        return false;
+    gHeader = static_cast<CacheHeader *>(map);
+    gData = static_cast<char *>(map) + sizeof(CacheHeader);
+    gTtlNs = ttlMs * nsPerMs;
+
+    std::string bootId;
+    if (android::base::ReadFileToString(bootIdPath, &bootId))
+        bootId = android::base::Trim(bootId);
+    bootId.resize(std::min(bootId.size(), sizeof(gHeader->bootId) - 1));
+
+    /* Nodes of an earlier boot, or of another layout, are never served. */
+    CacheLock lock(LOCK_EX);
+    if (memcmp(gHeader->magic, cacheMagic, sizeof(cacheMagic)) ||
+            strncmp(gHeader->bootId, bootId.c_str(), sizeof(gHeader->bootId))) {
+        memset(gHeader, 0, sizeof(*gHeader));
+        memcpy(gHeader->magic, cacheMagic, sizeof(cacheMagic));
+        strcpy(gHeader->bootId, bootId.c_str());
+    }
+    gActive = true;
+    return true;
+}
+
+bool nodeCacheActive() {
+    return gActive.load(std::memory_order_relaxed);
+}
+
+bool cachedNodePath(const std::string &path) {
+    if (path.size() >= entryPathSize)
+        return false;
+    if (android::base::EndsWith(path, registersDumpSuffix))
+        return true;
+    for (const char *prefix : debugfsPrefixes) {
+        if (!android::base::StartsWith(path, prefix))
+            continue;
+        for (const char *pattern : debugfsRegisterNodes) {
+            if (!fnmatch(pattern, path.c_str() + strlen(prefix), FNM_PATHNAME))
+                return true;
+        }
+    }
+    return false;
+}
+
+bool lookupCachedNode(const NodeCacheKey &key, std::string *content) {
+    CacheLock lock(LOCK_SH);
+    const int64_t now = boottimeNs();
+    const size_t slot = firstSlot(key.path);
+
+    for (size_t i = 0; i < probeLength; i++) {
+        const CacheEntry &entry = gHeader->entries[(slot + i) % entryCount];
+        if (!matches(entry, key.path))
+            continue;
+        if (!fresh(entry, now) || entry.inode != key.inode || entry.mtimeNs != key.mtimeNs)
+            return false;
+        /* Any run can write the file, so an entry is never trusted to stay in the ring. */
+        if (entry.len > maxNodeSize || entry.offset % dataSize + entry.len > dataSize)
+            return false;
+
+        content->assign(gData + entry.offset % dataSize, entry.len);
+        return true;
+    }
+    return false;
+}
+
+void storeCachedNode(const NodeCacheKey &key, const std::string &content) {
+    if (content.size() > maxNodeSize)
+        return;
+
+    CacheLock lock(LOCK_EX);
+    const int64_t now = boottimeNs();
+    const size_t slot = firstSlot(key.path);
+
+    /* The entry of the node itself, else one that expired, else the first one is replaced. */
+    CacheEntry *entry = nullptr;
+    for (size_t i = 0; i < probeLength && !entry; i++) {
+        CacheEntry *candidate = &gHeader->entries[(slot + i) % entryCount];
+        if (matches(*candidate, key.path))
+            entry = candidate;
+    }
+    for (size_t i = 0; i < probeLength && !entry; i++) {
+        CacheEntry *candidate = &gHeader->entries[(slot + i) % entryCount];
+        if (!fresh(*candidate, now))
+            entry = candidate;
+    }
+    if (!entry)
+        entry = &gHeader->entries[slot];
+
+    /* Content is never split over the end of the ring. */
+    if (gHeader->head % dataSize + content.size() > dataSize)
+        gHeader->head += dataSize - gHeader->head % dataSize;
+
+    memset(entry, 0, sizeof(*entry));
+    strcpy(entry->path, key.path.c_str());
+    entry->inode = key.inode;
+    entry->mtimeNs = key.mtimeNs;
+    entry->offset = gHeader->head;
+    entry->len = content.size();
+    memcpy(gData + gHeader->head % dataSize, content.data(), content.size());
+    gHeader->head += content.size();
+    entry->storedNs = now;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+
+/*
+ * Node cache shared between dump_power runs. Register dumps are slow to read
+ * over I2C, and dumps started close together by dumpstate, dumpsys and field
+ * tools read the same nodes. With the cache on, their content is kept in a
+ * file on tmpfs that every run maps shared, and a later run within the TTL is
+ * served from there instead of reading the node again. Only nodes that read
+ * chip registers are cached; other debugfs nodes, such as the tcpm logs, may
+ * be consumed when read and would be replayed as duplicates.
+ *
+ * An entry is keyed by the path of the node, its inode and its mtime, so a
+ * node that was recreated or touched is read again. The whole cache is reset
+ * on a new boot. Captures and replays bypass it.
+ */
+constexpr char defaultNodeCache[] = "/dev/dump_power/node_cache";
+constexpr int defaultNodeCacheTtlMs = 10 * 1000;
+
+struct NodeCacheKey {
+    std::string path;
+    uint64_t inode;
+    int64_t mtimeNs;
+};
+
+// Maps the cache file at |path|, creating it if needed. False if it can't be used.
+bool startNodeCache(const char *path, int ttlMs);
+bool nodeCacheActive();
+// Whether the node at |path| reads chip registers, which are slow enough to be cached.
+bool cachedNodePath(const std::string &path);
+
+// Copies the content stored for |key| within the TTL into |content|. False on a miss.
+bool lookupCachedNode(const NodeCacheKey &key, std::string *content);
+void storeCachedNode(const NodeCacheKey &key, const std::string &content);
@@ -0,0 +1,404 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_output.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include <android-base/file.h>
+
+#include "dump_power_compress.h"
+#include "dump_power_delta.h"
+#include "dump_power_io.h"
+#include "dump_power_logbuffer.h"
+#include "dump_power_profile.h"
+#include "dump_power_record.h"
+
+static thread_local SectionOutput *tCurrentOutput = nullptr;
+static std::atomic<bool> gOutputFailed(false);
+
+static constexpr size_t copyChunkSize = 32 * 1024;
+static constexpr size_t sendfileChunkSize = 1024 * 1024;
+
+/*
+ * Copies |in| to |out| from their current offsets. sendfile() moves the data
+ * inside the kernel; inputs which can't be spliced, like the logbuffer
+ * character devices, fall back to a fixed size read/write loop, which also
+ * tells a failed read from a failed write. Returns the bytes copied, or -1 if
+ * the first read already failed.
+ */
+static ssize_t copyFd(int in, int out) {
+    char buffer[copyChunkSize];
+    bool useSendfile = true;
+    ssize_t total = 0;
+
+    while (true) {
+        if (useSendfile) {
+            ssize_t ret = sendfile(out, in, nullptr, sendfileChunkSize);
+            if (ret > 0) {
+                total += ret;
+                continue;
+            }
+            if (ret == 0)
+                return total;
+            if (errno == EINTR)
+                continue;
+            useSendfile = false;
+        }
+
+        ssize_t len = TEMP_FAILURE_RETRY(read(in, buffer, sizeof(buffer)));
+        if (len <= 0)
+            return (len < 0 && !total) ? -1 : total;
+        if (!android::base::WriteFully(out, buffer, len)) {
+            gOutputFailed = true;
+            return total;
+        }
+        total += len;
+    }
+}
+
+/* writev() of all of |iov|, resuming after short writes. */
+static bool writevFully(int fd, std::vector<struct iovec> *iov) {
+    struct iovec *next = iov->data();
+    size_t count = iov->size();
+
+    while (count > 0) {
+        ssize_t len = TEMP_FAILURE_RETRY(writev(fd, next, std::min<size_t>(count, IOV_MAX)));
+        if (len <= 0) {
+            gOutputFailed = true;
+            return false;
+        }
+
+        while (count > 0 && static_cast<size_t>(len) >= next->iov_len) {
+            len -= next->iov_len;
+            next++;
+            count--;
+        }
+        if (count > 0) {
+            next->iov_base = static_cast<char *>(next->iov_base) + len;
+            next->iov_len -= len;
+        }
+    }
+    iov->clear();
+    return true;
+}
+
+void SectionOutput::append(const char *data, size_t len) {
+    /* Sized once for everything up to the spill, so a section never regrows it. */
+    if (mBuffer.capacity() < spillThreshold)
+        mBuffer.reserve(spillThreshold);
+    mBuffer.append(data, len);
+    if (mBuffer.size() >= spillThreshold)
+        spill();
+}
+
+/* vsnprintf() appending to |out|; returns the length added. */
+static int vformat(std::string *out, const char *fmt, va_list ap) {
+    char buffer[1024];
+    va_list apCopy;
+
+    va_copy(apCopy, ap);
+    int len = vsnprintf(buffer, sizeof(buffer), fmt, apCopy);
+    va_end(apCopy);
+    if (len < 0)
+        return len;
+
+    if (static_cast<size_t>(len) < sizeof(buffer)) {
+        out->append(buffer, len);
+        return len;
+    }
+
+    size_t offset = out->size();
+    out->resize(offset + len + 1);
+    vsnprintf(&(*out)[offset], len + 1, fmt, ap);
+    out->resize(offset + len);
+    return len;
+}
+
+int SectionOutput::vappendf(const char *fmt, va_list ap) {
+    if (mBuffer.capacity() < spillThreshold)
+        mBuffer.reserve(spillThreshold);
+    int len = vformat(&mBuffer, fmt, ap);
+
+    if (mBuffer.size() >= spillThreshold)
+        spill();
+    return len;
+}
+
+ssize_t SectionOutput::appendFromFd(int fd) {
+    const size_t start = mBuffer.size();
+    size_t total = 0;
+
+    /* Small files, which is nearly every sysfs node, stay in memory. */
+    while (total < spillThreshold) {
+        mBuffer.resize(start + total + copyChunkSize);
+        ssize_t len = TEMP_FAILURE_RETRY(read(fd, &mBuffer[start + total], copyChunkSize));
+        if (len <= 0) {
+            mBuffer.resize(start + total);
+            return (len < 0 && !total) ? -1 : total;
+        }
+        total += len;
+    }
+    mBuffer.resize(start + total);
+
+    if (!spill()) {
+        std::string rest;
+        android::base::ReadFdToString(fd, &rest);
+        mBuffer += rest;
+        return total + rest.size();
+    }
+
+    ssize_t copied = copyFd(fd, mDirect ? STDOUT_FILENO : mSpillFd.get());
+    return total + (copied > 0 ? copied : 0);
+}
+
+bool SectionOutput::spill() {
+    if (mDirect) {
+        if (!android::base::WriteFully(STDOUT_FILENO, mBuffer.data(), mBuffer.size())) {
+            gOutputFailed = true;
+            return false;
+        }
+        mBuffer.clear();
+        return true;
+    }
+
+    if (!mSpillFd.ok()) {
+        mSpillFd.reset(memfd_create("dump_power_section", MFD_CLOEXEC));
+        if (!mSpillFd.ok())
+            return false;
+    }
+
+    if (!android::base::WriteFully(mSpillFd, mBuffer.data(), mBuffer.size()))
+        return false;
+    mBuffer.clear();
+    return true;
+}
+
+void SectionOutput::emit() {
+    SectionOutput *output = this;
+    emitAll(&output, 1);
+}
+
+void SectionOutput::emitAll(SectionOutput *const *outputs, size_t count) {
+    std::vector<struct iovec> iov;
+
+    /* Whatever was printed outside of a section must come first. */
+    fflush(stdout);
+    for (size_t i = 0; i < count; i++) {
+        SectionOutput *output = outputs[i];
+
+        if (output->mSpillFd.ok()) {
+            writevFully(STDOUT_FILENO, &iov);
+            lseek(output->mSpillFd, 0, SEEK_SET);
+            copyFd(output->mSpillFd, STDOUT_FILENO);
+        }
+        if (!output->mBuffer.empty())
+            iov.push_back({output->mBuffer.data(), output->mBuffer.size()});
+    }
+    writevFully(STDOUT_FILENO, &iov);
+}
+
+void SectionOutput::clear() {
+    std::string().swap(mBuffer);
+    mSpillFd.reset();
+}
+
+ScopedSectionOutput::ScopedSectionOutput(SectionOutput *output) : mPrevious(tCurrentOutput) {
+    tCurrentOutput = output;
+}
+
+ScopedSectionOutput::~ScopedSectionOutput() {
+    tCurrentOutput = mPrevious;
+}
+
+void dumpPrintf(const char *fmt, ...) {
+    va_list ap;
+    int len;
+
+    va_start(ap, fmt);
+    if (structuredOutput() || deltaActive()) {
+        /* Both need the formatted text rather than just its bytes in the output. */
+        std::string text;
+        if (vformat(&text, fmt, ap) > 0)
+            dumpWrite(text.data(), text.size());
+        len = 0;
+    } else if (tCurrentOutput) {
+        len = tCurrentOutput->vappendf(fmt, ap);
+    } else {
+        len = vprintf(fmt, ap);
+    }
+    va_end(ap);
+
+    if (len > 0)
+        profileBytesWritten(len);
+}
+
+void dumpWrite(const char *data, size_t len) {
+    deltaText(data, len);
+    if (structuredOutput()) {
+        captureRecordText(data, len);
+        return;
+    }
+    dumpWriteRaw(data, len);
+}
+
+void dumpWriteRaw(const char *data, size_t len) {
+    if (tCurrentOutput)
+        tCurrentOutput->append(data, len);
+    else
+        fwrite(data, 1, len, stdout);
+    profileBytesWritten(len);
+}
+
+ssize_t dumpFromFd(int fd) {
+    ssize_t len;
+
+    if (structuredOutput()) {
+        std::string text;
+        if (!android::base::ReadFdToString(fd, &text) && text.empty())
+            return -1;
+        captureRecordText(text.data(), text.size());
+        return text.size();
+    }
+
+    if (tCurrentOutput) {
+        len = tCurrentOutput->appendFromFd(fd);
+    } else {
+        fflush(stdout);
+        len = copyFd(fd, STDOUT_FILENO);
+    }
+
+    if (len > 0)
+        profileBytesWritten(len);
+    return len;
+}
+
+/*
+ * dumpNodeContent() of a delta dump. The file is written only if it differs
+ * from the baseline; an unchanged file leaves a marker line.
+ */
+static void dumpContentDelta(const char *title, const char *file, const std::string *content) {
+    const std::string header = std::string("------ ") + title + " (" + file + ")";
+    std::string text;
+
+    if (!content) {
+        text = header + " ------\n";
+        dumpWrite(text.data(), text.size());
+        return;
+    }
+
+    if (deltaKeyChanged(title, file, *content))
+        text = header + " ------\n" + *content + "\n";
+    else
+        text = header + ": unchanged ------\n";
+    dumpWriteRaw(text.data(), text.size());
+}
+
+/* dumpFileContent() of a delta dump, which needs the whole file to compare. */
+static void dumpFileDelta(const char *title, const char *file) {
+    std::string content;
+
+    DumpNode node(file);
+    const bool read = node.ok() && (node.readToString(&content) || !content.empty());
+    dumpContentDelta(title, file, read ? &content : nullptr);
+}
+
+void dumpNodeContent(const char *title, const char *file, const std::string *content) {
+    if (structuredOutput()) {
+        dumpFileValueRecord(title, file, content);
+        return;
+    }
+
+    if (deltaActive()) {
+        dumpContentDelta(title, file, content);
+        return;
+    }
+
+    dumpPrintf("------ %s (%s) ------\n", title, file);
+    if (!content)
+        return;
+    dumpWrite(content->data(), content->size());
+    dumpWrite("\n", 1);
+}
+
+void dumpFileContent(const char *title, const char *file) {
+    if (logbufferTailed(file)) {
+        dumpLogbufferTail(title, file);
+        return;
+    }
+
+    if (structuredOutput()) {
+        dumpFileRecord(title, file);
+        return;
+    }
+
+    if (deltaActive()) {
+        dumpFileDelta(title, file);
+        return;
+    }
+
+    if (compressedFile(file)) {
+        dumpCompressedFile(title, file);
+        return;
+    }
+
+    dumpPrintf("------ %s (%s) ------\n", title, file);
+
+    DumpNode node(file);
+    if (!node.ok())
+        return;
+
+    if (node.unguarded()) {
+        ssize_t len = dumpFromFd(node.fd());
+        if (len < 0)
+            return;
+        node.addBytesRead(len);
+    } else {
+        /* Guarded nodes are read through their helper in bounded chunks. */
+        char buffer[copyChunkSize];
+        ssize_t len;
+        bool empty = true;
+
+        while ((len = node.read(buffer, sizeof(buffer))) > 0) {
+            dumpWrite(buffer, len);
+            empty = false;
+        }
+        if (len < 0 && empty)
+            return;
+    }
+
+    dumpWrite("\n", 1);
+}
+
+void discardSectionOutput() {
+    if (tCurrentOutput)
+        tCurrentOutput->clear();
+}
+
+bool dumpOutputFailed() {
+    /* Prints outside of a section go through stdio, which keeps its own error flag. */
+    return fflush(stdout) != 0 || ferror(stdout) || gOutputFailed;
+}
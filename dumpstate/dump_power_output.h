@@ -0,0 +1,93 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <string>
+
+#include <android-base/unique_fd.h>
+
+/*
+ * Buffered output of a single dump section. Sections write here instead of
+ * stdout, so that the many small prints of a section reach stdout in a few
+ * large writes, and so that the runner can emit every section in its original
+ * order once it has completed.
+ *
+ * Bulk file contents such as logbuffers are not kept on the heap: once a file
+ * or the buffer outgrows spillThreshold the output moves to a memfd, and the
+ * memfd is later copied to stdout by the kernel with sendfile(). A direct
+ * output, for sections that run in order, writes to stdout instead of
+ * spilling.
+ */
+class SectionOutput {
+  public:
+    static constexpr size_t spillThreshold = 64 * 1024;
+
+    explicit SectionOutput(bool direct = false) : mDirect(direct) {}
+
+    void append(const char *data, size_t len);
+    int vappendf(const char *fmt, va_list ap);
+    // Appends the rest of |fd|. Returns the bytes appended, or -1 if nothing could be read.
+    ssize_t appendFromFd(int fd);
+
+    // Writes everything appended so far to stdout.
+    void emit();
+    // emit() of |count| outputs in order, gathering their buffers into as few writev() as possible.
+    static void emitAll(SectionOutput *const *outputs, size_t count);
+    void clear();
+
+  private:
+    bool spill();
+
+    std::string mBuffer;
+    android::base::unique_fd mSpillFd;
+    bool mDirect;
+};
+
+/*
+ * Redirects everything the calling thread prints through dumpPrintf(),
+ * dumpWrite() and dumpFileContent() into |output| for the lifetime of the
+ * object. Without an active redirection the output goes straight to stdout.
+ */
+class ScopedSectionOutput {
+  public:
+    explicit ScopedSectionOutput(SectionOutput *output);
+    ~ScopedSectionOutput();
+
+  private:
+    SectionOutput *mPrevious;
+};
+
+/*
+ * Text output of a section. With structured output on, text is handed to the
+ * record layer instead; dumpWriteRaw() writes records regardless of format.
+ */
+void dumpPrintf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+void dumpWrite(const char *data, size_t len);
+void dumpWriteRaw(const char *data, size_t len);
+// Streams the rest of |fd| to the output. Returns -1 if nothing could be read.
+ssize_t dumpFromFd(int fd);
+// Same layout as libdump's dumpFileContent(), routed through the section output.
+void dumpFileContent(const char *title, const char *file);
+// dumpFileContent() of |file| read already, such as by a NodeBatch; null if it couldn't be read.
+void dumpNodeContent(const char *title, const char *file, const std::string *content);
+// Drops everything the current section has written so far.
+void discardSectionOutput();
+// Flushes stdout; whether any output of the dump failed to reach it, or got lost on the way.
+bool dumpOutputFailed();
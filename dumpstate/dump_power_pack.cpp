@@ -0,0 +1,246 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_pack.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <map>
+#include <mutex>
+
+#include <android-base/file.h>
+#include <android-base/unique_fd.h>
+
+namespace {
+
+constexpr char packMagic[8] = {'D', 'P', 'P', 'A', 'C', 'K', '1', '\0'};
+
+/*
+ * Pack layout: the header, then the paths and contents of all entries, then
+ * the index of entries sorted by path, which a replay binary searches.
+ */
+struct PackHeader {
+    char magic[8];
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t indexOffset;
+};
+
+enum PackType : uint32_t {
+    PACK_NODE = 0,
+    PACK_DIR = 1,
+};
+
+struct PackEntry {
+    uint64_t pathOffset;
+    uint64_t dataOffset;
+    uint64_t dataLen;
+    uint32_t pathLen;
+    uint32_t type;
+    int32_t openError;
+    int32_t readError;
+    int64_t elapsedNs;
+};
+
+struct Captured {
+    PackType type;
+    // Node content, or the directory entries separated by '\0'.
+    std::string data;
+    int openError;
+    int readError;
+    int64_t elapsedNs;
+    // Whether the node was read, rather than only opened.
+    bool read;
+};
+
+PackMode gPackMode = PackMode::NONE;
+std::string gPackPath;
+
+std::mutex gCaptureLock;
+// Keyed by type and path, so that a directory and a node of the same name stay apart.
+std::map<std::pair<std::string, PackType>, Captured> gCaptured;
+
+const char *gPack = nullptr;
+const PackEntry *gIndex = nullptr;
+uint32_t gIndexCount = 0;
+
+/* Directories are looked up without their trailing slash, however they were opened. */
+std::string dirKey(const std::string &path) {
+    size_t end = path.find_last_not_of('/');
+    return end == std::string::npos ? "/" : path.substr(0, end + 1);
+}
+
+void capture(std::string path, Captured captured) {
+    std::lock_guard<std::mutex> lock(gCaptureLock);
+    auto [it, added] = gCaptured.emplace(std::make_pair(std::move(path), captured.type),
+                                         captured);
+    /* A node only opened, such as by isValidFile(), gives way to its first read. */
+    if (!added && !it->second.read && captured.read)
+        it->second = std::move(captured);
+}
+
+int comparePath(const PackEntry &entry, const std::string &path, PackType type) {
+    int cmp = memcmp(gPack + entry.pathOffset, path.data(), std::min<size_t>(entry.pathLen,
+                                                                             path.size()));
+    if (cmp)
+        return cmp;
+    if (entry.pathLen != path.size())
+        return entry.pathLen < path.size() ? -1 : 1;
+    return entry.type == type ? 0 : (entry.type < type ? -1 : 1);
+}
+
+const PackEntry *findEntry(const std::string &path, PackType type) {
+    uint32_t low = 0, high = gIndexCount;
+
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        int cmp = comparePath(gIndex[mid], path, type);
+        if (!cmp)
+            return &gIndex[mid];
+        if (cmp < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+PackMode packMode() {
+    return gPackMode;
+}
+
+void startCapture(const char *path) {
+    gPackMode = PackMode::CAPTURE;
+    gPackPath = path;
+}
+
+bool finishCapture() {
+    std::lock_guard<std::mutex> lock(gCaptureLock);
+    std::string pack(sizeof(PackHeader), '\0');
+    std::vector<PackEntry> index;
+
+    for (const auto &[key, captured] : gCaptured) {
+        PackEntry entry = {};
+        entry.pathOffset = pack.size();
+        entry.pathLen = key.first.size();
+        pack.append(key.first);
+        entry.dataOffset = pack.size();
+        entry.dataLen = captured.data.size();
+        pack.append(captured.data);
+        entry.type = captured.type;
+        entry.openError = captured.openError;
+        entry.readError = captured.readError;
+        entry.elapsedNs = captured.elapsedNs;
+        index.push_back(entry);
+    }
+
+    pack.resize((pack.size() + alignof(PackEntry) - 1) & ~(alignof(PackEntry) - 1), '\0');
+    PackHeader header = {};
+    memcpy(header.magic, packMagic, sizeof(packMagic));
+    header.count = index.size();
+    header.indexOffset = pack.size();
+    memcpy(&pack[0], &header, sizeof(header));
+    pack.append(reinterpret_cast<const char *>(index.data()), index.size() * sizeof(PackEntry));
+
+    android::base::unique_fd fd(TEMP_FAILURE_RETRY(
+            open(gPackPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)));
+    return fd.ok() && android::base::WriteStringToFd(pack, fd);
+}
+
+bool startReplay(const char *path) {
+    android::base::unique_fd fd(TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC)));
+    struct stat st;
+
+    if (!fd.ok() || fstat(fd, &st) || static_cast<size_t>(st.st_size) < sizeof(PackHeader))
+        return false;
+
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED)
+        return false;
+
+    const PackHeader *header = static_cast<const PackHeader *>(map);
+    const size_t size = st.st_size;
+    if (memcmp(header->magic, packMagic, sizeof(packMagic)) ||
+            header->indexOffset % alignof(PackEntry) || header->indexOffset > size ||
+            (size - header->indexOffset) / sizeof(PackEntry) < header->count) {
+        munmap(map, size);
+        return false;
+    }
+
+    const PackEntry *index =
+            reinterpret_cast<const PackEntry *>(static_cast<const char *>(map) + header->indexOffset);
+    for (uint32_t i = 0; i < header->count; i++) {
+        if (index[i].pathOffset + index[i].pathLen > header->indexOffset ||
+                index[i].dataOffset + index[i].dataLen > header->indexOffset) {
+            munmap(map, size);
+            return false;
+        }
+    }
+
+    /* The mapping lives for the rest of the process. */
+    gPack = static_cast<const char *>(map);
+    gIndex = index;
+    gIndexCount = header->count;
+    gPackMode = PackMode::REPLAY;
+    return true;
+}
+
+void captureNode(const std::string &path, const std::string &content, int openError,
+                 int readError, std::chrono::nanoseconds elapsed, bool read) {
+    capture(path, {PACK_NODE, content, openError, readError, elapsed.count(), read});
+}
+
+void captureDir(const std::string &path, const std::vector<const char *> &names, int openError) {
+    std::string data;
+
+    for (const char *name : names)
+        data.append(name, strlen(name) + 1);
+    capture(dirKey(path), {PACK_DIR, std::move(data), openError, 0, 0, true});
+}
+
+bool findPackNode(const std::string &path, PackNode *node) {
+    const PackEntry *entry = findEntry(path, PACK_NODE);
+
+    if (!entry)
+        return false;
+    node->data = gPack + entry->dataOffset;
+    node->len = entry->dataLen;
+    node->openError = entry->openError;
+    node->readError = entry->readError;
+    node->elapsed = std::chrono::nanoseconds(entry->elapsedNs);
+    return true;
+}
+
+bool findPackDir(const std::string &path, std::vector<const char *> *names, int *openError) {
+    const PackEntry *entry = findEntry(dirKey(path), PACK_DIR);
+
+    names->clear();
+    if (!entry)
+        return false;
+
+    /* Every name, the last one included, is terminated in the pack. */
+    const char *data = gPack + entry->dataOffset;
+    for (size_t offset = 0; offset < entry->dataLen; offset += strlen(data + offset) + 1)
+        names->push_back(data + offset);
+    *openError = entry->openError;
+    return true;
+}
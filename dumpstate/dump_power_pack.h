@@ -0,0 +1,70 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/*
+ * Capture and replay of the nodes that a dump reads. A capture records the
+ * content, errors and read time of every node and the entries of every
+ * directory that DumpNode and NodeDir access into a single pack file; a
+ * replay serves those accesses from the pack, mapped read-only, instead of
+ * the live filesystem. Sections can so be profiled and checked on a host
+ * against the nodes of a real device.
+ *
+ * A pack keeps the first read of each path; a node read twice in a dump is
+ * replayed with the same content both times. A node that was only opened,
+ * such as to check that it exists, is kept only until it is read.
+ */
+enum class PackMode {
+    NONE,
+    CAPTURE,
+    REPLAY,
+};
+
+PackMode packMode();
+void startCapture(const char *path);
+// Writes the pack of the capture. Returns false on errors.
+bool finishCapture();
+// Maps the pack at |path| and replays it. Returns false if it's no valid pack.
+bool startReplay(const char *path);
+
+// A node as captured; data stays valid for the rest of the replay.
+struct PackNode {
+    const char *data;
+    size_t len;
+    // errno of the failed open or of the read that ended the node, or 0.
+    int openError;
+    int readError;
+    std::chrono::nanoseconds elapsed;
+};
+
+// |read| tells a node that was read from one that was only opened.
+void captureNode(const std::string &path, const std::string &content, int openError,
+                 int readError, std::chrono::nanoseconds elapsed, bool read);
+// Captures the entries of the directory |path|, or |openError| if it can't be opened.
+void captureDir(const std::string &path, const std::vector<const char *> &names, int openError);
+
+// Looks up a captured node; false if the dump never read |path|.
+bool findPackNode(const std::string &path, PackNode *node);
+// Looks up a captured directory. Its names stay valid for the rest of the replay.
+bool findPackDir(const std::string &path, std::vector<const char *> *names, int *openError);
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_pack.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <android-base/file.h>
+#include <android-base/unique_fd.h>
+
+#include "dump_power_io.h"
+#include "dump_power_sections.h"
+
+namespace {
+
+constexpr char eusbRegisters[] = "d/eusb_repeater/registers";
+
+/* Runs the section |name| and returns what it wrote to stdout. */
+std::string runSection(const char *name) {
+    TemporaryFile out;
+    android::base::unique_fd saved(dup(STDOUT_FILENO));
+    std::string content;
+
+    fflush(stdout);
+    dup2(out.fd, STDOUT_FILENO);
+    for (size_t i = 0; i < dumpSectionCount; i++) {
+        if (!strcmp(dumpSections[i].name, name))
+            dumpSections[i].dump();
+    }
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+
+    android::base::ReadFileToString(out.path, &content);
+    return content;
+}
+
+/*
+ * The eUSB repeater section opens its node with isValidFile() before it dumps
+ * it, so the capture sees the node opened without a read first.
+ */
+TEST(PackTest, ReplaysNodesCheckedBeforeTheyAreRead) {
+    TemporaryDir root;
+    TemporaryFile pack;
+    const std::string node = std::string(root.path) + "/" + eusbRegisters;
+
+    ASSERT_EQ(0, mkdir((std::string(root.path) + "/d").c_str(), 0755));
+    ASSERT_EQ(0, mkdir((std::string(root.path) + "/d/eusb_repeater").c_str(), 0755));
+    ASSERT_TRUE(android::base::WriteStringToFile("0x00: 0x1f\n0x01: 0x80\n", node));
+    ASSERT_TRUE(setNodeRoot(root.path));
+
+    startCapture(pack.path);
+    const std::string captured = runSection("eusb_repeater");
+    ASSERT_TRUE(finishCapture());
+    EXPECT_NE(std::string::npos, captured.find("0x00: 0x1f\n0x01: 0x80\n"));
+
+    /* The replay must not look at the node again. */
+    ASSERT_TRUE(android::base::WriteStringToFile("0x00: 0x00\n", node));
+    ASSERT_TRUE(startReplay(pack.path));
+    EXPECT_EQ(captured, runSection("eusb_repeater"));
+}
+
+}  // namespace
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_profile.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "dump_power_record.h"
+
+static thread_local SectionProfile *tCurrentProfile = nullptr;
+
+static int64_t toUs(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+ScopedSectionProfile::ScopedSectionProfile(SectionProfile *profile)
+    : mPrevious(tCurrentProfile), mProfile(profile), mStart(std::chrono::steady_clock::now()) {
+    tCurrentProfile = profile;
+}
+
+ScopedSectionProfile::~ScopedSectionProfile() {
+    if (mProfile)
+        mProfile->wallUs = toUs(std::chrono::steady_clock::now() - mStart);
+    tCurrentProfile = mPrevious;
+}
+
+bool profileActive() {
+    return tCurrentProfile != nullptr;
+}
+
+void profileFileOpened() {
+    if (tCurrentProfile)
+        tCurrentProfile->filesOpened++;
+}
+
+void profileBytesRead(size_t len) {
+    if (tCurrentProfile)
+        tCurrentProfile->bytesRead += len;
+}
+
+void profileBytesWritten(size_t len) {
+    if (tCurrentProfile)
+        tCurrentProfile->bytesWritten += len;
+}
+
+void profileDirScan() {
+    if (tCurrentProfile)
+        tCurrentProfile->dirScans++;
+}
+
+void profileNodeTimeout() {
+    if (tCurrentProfile)
+        tCurrentProfile->timeouts++;
+}
+
+void profileNodeDone(const char *path, std::chrono::steady_clock::duration elapsed) {
+    if (!tCurrentProfile)
+        return;
+
+    int64_t us = toUs(elapsed);
+    if (tCurrentProfile->slowestNode.empty() || us > tCurrentProfile->slowestNodeUs) {
+        tCurrentProfile->slowestNodeUs = us;
+        tCurrentProfile->slowestNode = path;
+    }
+}
+
+void printProfileTable(const std::vector<SectionProfile> &profiles) {
+    if (structuredOutput()) {
+        ScopedRecordSection scopedRecords("dump_power_profile");
+        for (const auto &profile : profiles) {
+            std::string prefix = std::string(profile.name) + ".";
+            dumpRecord(prefix + "wall_us", profile.wallUs, "");
+            dumpRecord(prefix + "files_opened", profile.filesOpened, "");
+            dumpRecord(prefix + "bytes_read", profile.bytesRead, "");
+            dumpRecord(prefix + "bytes_written", profile.bytesWritten, "");
+            dumpRecord(prefix + "dir_scans", profile.dirScans, "");
+            dumpRecord(prefix + "timeouts", profile.timeouts, "");
+            dumpRecord(prefix + "slowest_node_us", profile.slowestNodeUs, profile.slowestNode);
+        }
+        return;
+    }
+
+    printf("\n------ dump_power profile ------\n");
+    printf("section\twall_us\tfiles_opened\tbytes_read\tbytes_written\tdir_scans"
+           "\ttimeouts\tslowest_node_us\tslowest_node\n");
+    for (const auto &profile : profiles) {
+        printf("%s\t%" PRId64 "\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64
+               "\t%" PRId64 "\t%s\n",
+               profile.name, profile.wallUs, profile.filesOpened, profile.bytesRead,
+               profile.bytesWritten, profile.dirScans, profile.timeouts, profile.slowestNodeUs,
+               profile.slowestNode.empty() ? "-" : profile.slowestNode.c_str());
+    }
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/* Cost of one dump section, collected when dump_power runs with --profile. */
+struct SectionProfile {
+    const char *name = nullptr;
+    int64_t wallUs = 0;
+    uint64_t filesOpened = 0;
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t dirScans = 0;
+    uint64_t timeouts = 0;
+    int64_t slowestNodeUs = 0;
+    std::string slowestNode;
+};
+
+/*
+ * Accounts all node accesses and output of the calling thread to |profile|
+ * for the lifetime of the object, and records the section's wall time. A null
+ * |profile| leaves profiling off.
+ */
+class ScopedSectionProfile {
+  public:
+    explicit ScopedSectionProfile(SectionProfile *profile);
+    ~ScopedSectionProfile();
+
+  private:
+    SectionProfile *mPrevious;
+    SectionProfile *mProfile;
+    std::chrono::steady_clock::time_point mStart;
+};
+
+bool profileActive();
+void profileFileOpened();
+void profileBytesRead(size_t len);
+void profileBytesWritten(size_t len);
+void profileDirScan();
+void profileNodeTimeout();
+void profileNodeDone(const char *path, std::chrono::steady_clock::duration elapsed);
+
+// Prints the trailing tab separated profile table.
+void printProfileTable(const std::vector<SectionProfile> &profiles);
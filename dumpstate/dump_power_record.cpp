@@ -0,0 +1,326 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_record.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+
+#include "dump_power_delta.h"
+#include "dump_power_io.h"
+#include "dump_power_output.h"
+
+namespace {
+
+std::atomic<OutputFormat> gFormat(OutputFormat::TEXT);
+
+thread_local const char *tSectionName = nullptr;
+thread_local bool tTypedRecords = false;
+thread_local std::string tText;
+/* Markers raised while a streamed record is open are written after it. */
+thread_local bool tRecordOpen = false;
+thread_local std::string tPendingMarkers;
+
+/*
+ * Length of the valid UTF-8 sequence at the start of |s|, 0 if it is not
+ * valid, or -1 if it is valid so far but cut off after |len| bytes.
+ */
+int utf8SequenceLength(const unsigned char *s, size_t len) {
+    unsigned char low = 0x80;
+    unsigned char high = 0xbf;
+    size_t count;
+
+    /* Overlong forms, surrogates and code points past U+10FFFF are not valid. */
+    if (s[0] >= 0xc2 && s[0] <= 0xdf) {
+        count = 2;
+    } else if (s[0] >= 0xe0 && s[0] <= 0xef) {
+        count = 3;
+        if (s[0] == 0xe0)
+            low = 0xa0;
+        else if (s[0] == 0xed)
+            high = 0x9f;
+    } else if (s[0] >= 0xf0 && s[0] <= 0xf4) {
+        count = 4;
+        if (s[0] == 0xf0)
+            low = 0x90;
+        else if (s[0] == 0xf4)
+            high = 0x8f;
+    } else {
+        return 0;
+    }
+
+    for (size_t i = 1; i < count; i++) {
+        if (i >= len)
+            return -1;
+        if (s[i] < (i == 1 ? low : 0x80) || s[i] > (i == 1 ? high : 0xbf))
+            return 0;
+    }
+    return count;
+}
+
+/*
+ * Appends |data| escaped as the inside of a JSON string. Valid UTF-8 is kept
+ * as it is; control characters and bytes that aren't part of valid UTF-8 keep
+ * their value as a code point, so the line is always valid UTF-8 whatever the
+ * driver wrote. With |more|, a sequence cut off by the end of |data| is left
+ * for the next chunk. Returns the number of bytes consumed.
+ */
+size_t appendJsonString(std::string *out, const char *data, size_t len, bool more = false) {
+    const char digits[] = "0123456789abcdef";
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = bytes[i];
+        switch (c) {
+        case '"':
+            out->append("\\\"");
+            break;
+        case '\\':
+            out->append("\\\\");
+            break;
+        case '\n':
+            out->append("\\n");
+            break;
+        case '\t':
+            out->append("\\t");
+            break;
+        case '\r':
+            out->append("\\r");
+            break;
+        default:
+            if (c >= 0x20 && c < 0x7f) {
+                out->push_back(c);
+                break;
+            }
+            if (c >= 0x80) {
+                int sequence = utf8SequenceLength(bytes + i, len - i);
+                if (sequence < 0 && more)
+                    return i;
+                if (sequence > 0) {
+                    out->append(data + i, sequence);
+                    i += sequence - 1;
+                    break;
+                }
+            }
+            out->append("\\u00");
+            out->push_back(digits[c >> 4]);
+            out->push_back(digits[c & 0xf]);
+        }
+    }
+    return len;
+}
+
+void appendJsonString(std::string *out, const std::string &value) {
+    appendJsonString(out, value.data(), value.size());
+}
+
+/* Writes the record up to and including `"value":`. */
+std::string recordHead(const std::string &key, const std::string &path) {
+    std::string head("{\"section\":\"");
+
+    appendJsonString(&head, tSectionName ? tSectionName : "");
+    head.append("\",\"key\":\"");
+    appendJsonString(&head, key);
+    head.append("\",\"path\":\"");
+    appendJsonString(&head, path);
+    head.append("\",\"value\":");
+    return head;
+}
+
+std::string stringRecord(const std::string &key, const std::string &value, const std::string &path) {
+    std::string record = recordHead(key, path);
+
+    record.push_back('"');
+    appendJsonString(&record, value);
+    record.append("\"}\n");
+    return record;
+}
+
+void writeStringRecord(const std::string &key, const std::string &value, const std::string &path) {
+    std::string record = stringRecord(key, value, path);
+    dumpWriteRaw(record.data(), record.size());
+}
+
+/* Plain JSON numbers only: no leading zeros, exponents or hex. */
+bool isJsonNumber(const std::string &value) {
+    size_t i = 0;
+
+    if (i < value.size() && value[i] == '-')
+        i++;
+    if (i >= value.size() || !isdigit(value[i]))
+        return false;
+    if (value[i] == '0' && i + 1 < value.size() && isdigit(value[i + 1]))
+        return false;
+    while (i < value.size() && isdigit(value[i]))
+        i++;
+    if (i < value.size() && value[i] == '.') {
+        i++;
+        if (i >= value.size() || !isdigit(value[i]))
+            return false;
+        while (i < value.size() && isdigit(value[i]))
+            i++;
+    }
+    return i == value.size();
+}
+
+}  // namespace
+
+void setOutputFormat(OutputFormat format) {
+    gFormat = format;
+}
+
+bool structuredOutput() {
+    return gFormat.load(std::memory_order_relaxed) == OutputFormat::JSON;
+}
+
+ScopedRecordSection::ScopedRecordSection(const char *name) : mPrevious(tSectionName) {
+    tSectionName = name;
+    tTypedRecords = false;
+    tText.clear();
+}
+
+ScopedRecordSection::~ScopedRecordSection() {
+    if (structuredOutput() && !tTypedRecords && !tText.empty())
+        writeStringRecord("text", tText, "");
+
+    std::string().swap(tText);
+    tTypedRecords = false;
+    tSectionName = mPrevious;
+}
+
+void dumpRecord(const std::string &key, int64_t value, const std::string &path) {
+    if (!structuredOutput())
+        return;
+
+    char number[32];
+    int len = snprintf(number, sizeof(number), "%" PRId64, value);
+
+    tTypedRecords = true;
+    if (!deltaKeyChanged(key, path, number))
+        return;
+
+    std::string record = recordHead(key, path);
+    record.append(number, len);
+    record.append("}\n");
+    dumpWriteRaw(record.data(), record.size());
+}
+
+void dumpRecord(const std::string &key, const std::string &value, const std::string &path) {
+    if (!structuredOutput())
+        return;
+
+    tTypedRecords = true;
+    if (deltaKeyChanged(key, path, value))
+        writeStringRecord(key, value, path);
+}
+
+void dumpRecordValue(const std::string &key, const std::string &value, const std::string &path) {
+    if (!structuredOutput())
+        return;
+
+    if (!isJsonNumber(value)) {
+        dumpRecord(key, value, path);
+        return;
+    }
+
+    tTypedRecords = true;
+    if (!deltaKeyChanged(key, path, value))
+        return;
+
+    std::string record = recordHead(key, path);
+    record.append(value);
+    record.append("}\n");
+    dumpWriteRaw(record.data(), record.size());
+}
+
+void dumpMarkerRecord(const std::string &key, const std::string &path) {
+    if (tRecordOpen) {
+        tPendingMarkers += stringRecord(key, path, path);
+        return;
+    }
+    writeStringRecord(key, path, path);
+}
+
+void dumpFileRecord(const char *title, const char *file) {
+    std::string record = recordHead(title, file);
+    char buffer[16 * 1024];
+    size_t carried = 0;
+    ssize_t len;
+    bool empty = true;
+
+    DumpNode node(file);
+    if (!node.ok()) {
+        record.append("null}\n");
+        dumpWriteRaw(record.data(), record.size());
+        return;
+    }
+
+    /* A delta dump needs the whole value to tell whether it changed. */
+    if (deltaActive()) {
+        std::string value;
+        const bool read = node.readToString(&value) || !value.empty();
+        dumpFileValueRecord(title, file, read ? &value : nullptr);
+        return;
+    }
+
+    /*
+     * The value is escaped chunk by chunk, so a large logbuffer is never held
+     * whole. A UTF-8 sequence split between chunks is carried to the next one.
+     */
+    tRecordOpen = true;
+    record.push_back('"');
+    while ((len = node.read(buffer + carried, sizeof(buffer) - carried)) > 0) {
+        const size_t total = carried + len;
+        const size_t used = appendJsonString(&record, buffer, total, true);
+        carried = total - used;
+        memmove(buffer, buffer + used, carried);
+        dumpWriteRaw(record.data(), record.size());
+        record.clear();
+        empty = false;
+    }
+    appendJsonString(&record, buffer, carried);
+    if (len < 0 && empty) {
+        record = recordHead(title, file);
+        record.append("null}\n");
+    } else {
+        record.append("\"}\n");
+    }
+    tRecordOpen = false;
+    record += tPendingMarkers;
+    tPendingMarkers.clear();
+    dumpWriteRaw(record.data(), record.size());
+}
+
+void dumpFileValueRecord(const char *title, const char *file, const std::string *value) {
+    if (!value) {
+        std::string record = recordHead(title, file);
+        record.append("null}\n");
+        dumpWriteRaw(record.data(), record.size());
+    } else if (deltaKeyChanged(title, file, *value)) {
+        writeStringRecord(title, *value, file);
+    }
+}
+
+void captureRecordText(const char *data, size_t len) {
+    tText.append(data, len);
+}
+
+void discardRecordText() {
+    tText.clear();
+}
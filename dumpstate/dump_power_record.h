@@ -0,0 +1,69 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+/*
+ * Structured output. With OutputFormat::JSON every section is written as JSON
+ * lines of the form
+ *
+ *   {"section":"mitigation_stats","key":"ocp_cpu1.count","path":"...","value":3}
+ *
+ * where value is a number or a string. Sections report their values with
+ * dumpRecord(); files dumped with dumpFileContent() become one string record
+ * keyed by their title. Free text of a section that reports no typed records
+ * is kept as a single "text" record, so nothing is lost in sections that have
+ * not been converted.
+ */
+enum class OutputFormat {
+    TEXT,
+    JSON,
+};
+
+void setOutputFormat(OutputFormat format);
+bool structuredOutput();
+
+// Names the records of the calling thread, and writes its text record when it ends.
+class ScopedRecordSection {
+  public:
+    explicit ScopedRecordSection(const char *name);
+    ~ScopedRecordSection();
+
+  private:
+    const char *mPrevious;
+};
+
+void dumpRecord(const std::string &key, int64_t value, const std::string &path);
+void dumpRecord(const std::string &key, const std::string &value, const std::string &path);
+// Reports |value| as a number when it is one, and as a string otherwise.
+void dumpRecordValue(const std::string &key, const std::string &value, const std::string &path);
+
+// Reports an event such as a node TIMEOUT; unlike dumpRecord() it keeps the text record.
+void dumpMarkerRecord(const std::string &key, const std::string &path);
+
+// Structured counterpart of dumpFileContent(), streaming |file| into the value.
+void dumpFileRecord(const char *title, const char *file);
+// dumpFileRecord() of a value read already; a null |value| is written as a node that can't be read.
+void dumpFileValueRecord(const char *title, const char *file, const std::string *value);
+// Collects free text of the current section while structured output is on.
+void captureRecordText(const char *data, size_t len);
+// Drops the text collected so far, so the section writes no text record.
+void discardRecordText();
@@ -0,0 +1,346 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_regmap.h"
+
+#include <algorithm>
+#include <charconv>
+
+#include "dump_power_compress.h"
+#include "dump_power_delta.h"
+#include "dump_power_io.h"
+#include "dump_power_output.h"
+#include "dump_power_record.h"
+#include "dump_power_table.h"
+
+namespace {
+
+constexpr RegisterField bit(const char *name, int n) {
+    return {name, static_cast<uint8_t>(n), 1};
+}
+
+constexpr RegisterField bits(const char *name, int high, int low) {
+    return {name, static_cast<uint8_t>(low), static_cast<uint8_t>(high - low + 1)};
+}
+
+template <size_t N>
+constexpr bool sortedByAddress(const RegisterDef (&registers)[N]) {
+    for (size_t i = 1; i < N; i++) {
+        if (registers[i - 1].address >= registers[i].address)
+            return false;
+    }
+    return true;
+}
+
+template <size_t N>
+constexpr bool fieldsFit(const RegisterDef (&registers)[N], int registerBits) {
+    for (const auto &reg : registers) {
+        for (const auto &field : reg.fields) {
+            if (field.name && (field.width == 0 || field.shift + field.width > registerBits))
+                return false;
+        }
+    }
+    return true;
+}
+
+/* USB Type-C Port Controller Interface registers, one byte per address. */
+constexpr RegisterDef tcpciRegisters[] = {
+        {0x00, "VENDOR_ID_L", {}},
+        {0x01, "VENDOR_ID_H", {}},
+        {0x02, "PRODUCT_ID_L", {}},
+        {0x03, "PRODUCT_ID_H", {}},
+        {0x04, "DEVICE_ID_L", {}},
+        {0x05, "DEVICE_ID_H", {}},
+        {0x06, "USBTYPEC_REV_L", {}},
+        {0x07, "USBTYPEC_REV_H", {}},
+        {0x08, "USBPD_REV_VER_L", {}},
+        {0x09, "USBPD_REV_VER_H", {}},
+        {0x0a, "PD_INTERFACE_REV_L", {}},
+        {0x0b, "PD_INTERFACE_REV_H", {}},
+        {0x10, "ALERT_L", {bit("cc_status", 0), bit("power_status", 1), bit("rx_status", 2),
+                           bit("rx_hard_reset", 3), bit("tx_failed", 4), bit("tx_discarded", 5),
+                           bit("tx_success", 6), bit("v_alarm_hi", 7)}},
+        {0x11, "ALERT_H", {bit("v_alarm_lo", 0), bit("fault", 1), bit("rx_buf_overflow", 2),
+                           bit("vbus_disconnect", 3), bit("extended_status", 5),
+                           bit("alert_extended", 6), bit("vendor_defined", 7)}},
+        {0x12, "ALERT_MASK_L", {}},
+        {0x13, "ALERT_MASK_H", {}},
+        {0x14, "POWER_STATUS_MASK", {}},
+        {0x15, "FAULT_STATUS_MASK", {}},
+        {0x16, "EXTENDED_STATUS_MASK", {}},
+        {0x17, "ALERT_EXTENDED_MASK", {}},
+        {0x18, "CONFIG_STANDARD_OUTPUT", {}},
+        {0x19, "TCPC_CONTROL", {bit("orientation", 0), bit("bist_test_mode", 1),
+                                bits("i2c_clock_stretch", 3, 2), bit("debug_acc_control", 4),
+                                bit("watchdog_en", 5), bit("look4connection_alert_en", 6),
+                                bit("smbus_pec_en", 7)}},
+        {0x1a, "ROLE_CONTROL", {bits("cc1", 1, 0), bits("cc2", 3, 2), bits("rp_value", 5, 4),
+                                bit("drp", 6)}},
+        {0x1b, "FAULT_CONTROL", {bit("vconn_ocp_dis", 0), bit("vbus_ovp_dis", 1),
+                                 bit("vbus_ocp_dis", 2), bit("vbus_discharge_fault_dis", 3),
+                                 bit("force_off_vbus_dis", 4)}},
+        {0x1c, "POWER_CONTROL", {bit("vconn_en", 0), bit("vconn_power_supported", 1),
+                                 bit("force_discharge", 2), bit("bleed_discharge", 3),
+                                 bit("auto_discharge", 4), bit("volt_alarm_dis", 5),
+                                 bit("vbus_volt_mon_dis", 6), bit("fast_role_swap_en", 7)}},
+        {0x1d, "CC_STATUS", {bits("cc1_state", 1, 0), bits("cc2_state", 3, 2),
+                             bit("connect_result", 4), bit("looking4connection", 5)}},
+        {0x1e, "POWER_STATUS", {bit("sinking_vbus", 0), bit("vconn_present", 1),
+                                bit("vbus_present", 2), bit("vbus_detect_en", 3),
+                                bit("sourcing_vbus", 4), bit("sourcing_hv", 5),
+                                bit("tcpc_init_status", 6), bit("debug_acc_connected", 7)}},
+        {0x1f, "FAULT_STATUS", {bit("i2c_error", 0), bit("vconn_oc", 1), bit("vbus_ovp", 2),
+                                bit("vbus_ocp", 3), bit("force_discharge_fail", 4),
+                                bit("auto_discharge_fail", 5), bit("force_off_vbus", 6),
+                                bit("all_regs_reset", 7)}},
+        {0x20, "EXTENDED_STATUS", {bit("vsafe0v", 0)}},
+        {0x21, "ALERT_EXTENDED", {bit("sink_frs", 0), bit("source_frs", 1),
+                                  bit("timer_expired", 2)}},
+        {0x23, "COMMAND", {}},
+        {0x24, "DEVICE_CAPABILITIES_1_L", {}},
+        {0x25, "DEVICE_CAPABILITIES_1_H", {}},
+        {0x26, "DEVICE_CAPABILITIES_2_L", {}},
+        {0x27, "DEVICE_CAPABILITIES_2_H", {}},
+        {0x28, "STANDARD_INPUT_CAPABILITIES", {}},
+        {0x29, "STANDARD_OUTPUT_CAPABILITIES", {}},
+        {0x2a, "CONFIG_EXTENDED1", {}},
+        {0x2e, "MESSAGE_HEADER_INFO", {bit("power_role", 0), bits("pd_revision", 2, 1),
+                                       bit("data_role", 3), bit("cable_plug", 4)}},
+        {0x2f, "RECEIVE_DETECT", {bit("sop", 0), bit("sop1", 1), bit("sop2", 2),
+                                  bit("sop1_debug", 3), bit("sop2_debug", 4),
+                                  bit("hard_reset", 5), bit("cable_reset", 6)}},
+        {0x30, "RX_BYTE_COUNT", {}},
+        {0x50, "TRANSMIT", {}},
+        {0x51, "TX_BYTE_COUNT", {}},
+        {0x70, "VBUS_VOLTAGE_L", {}},
+        {0x71, "VBUS_VOLTAGE_H", {bits("measurement_h", 1, 0), bits("scale_factor", 3, 2)}},
+        {0x72, "VBUS_SINK_DISCONNECT_THRESHOLD_L", {}},
+        {0x73, "VBUS_SINK_DISCONNECT_THRESHOLD_H", {}},
+        {0x74, "VBUS_STOP_DISCHARGE_THRESHOLD_L", {}},
+        {0x75, "VBUS_STOP_DISCHARGE_THRESHOLD_H", {}},
+        {0x76, "VBUS_VOLTAGE_ALARM_HI_CFG_L", {}},
+        {0x77, "VBUS_VOLTAGE_ALARM_HI_CFG_H", {}},
+        {0x78, "VBUS_VOLTAGE_ALARM_LO_CFG_L", {}},
+        {0x79, "VBUS_VOLTAGE_ALARM_LO_CFG_H", {}},
+};
+static_assert(sortedByAddress(tcpciRegisters) && fieldsFit(tcpciRegisters, 8));
+
+/* ModelGauge m5 registers of the MAX1720x fuel gauges, 16 bits each. */
+constexpr RegisterDef maxfgRegisters[] = {
+        {0x00, "Status", {bit("por", 1), bit("imn", 2), bit("bst", 3), bit("imx", 6),
+                          bit("dsoci", 7), bit("vmn", 8), bit("tmn", 9), bit("smn", 10),
+                          bit("bi", 11), bit("vmx", 12), bit("tmx", 13), bit("smx", 14),
+                          bit("br", 15)}},
+        {0x01, "VAlrtTh", {bits("min", 7, 0), bits("max", 15, 8)}},
+        {0x02, "TAlrtTh", {bits("min", 7, 0), bits("max", 15, 8)}},
+        {0x03, "SAlrtTh", {bits("min", 7, 0), bits("max", 15, 8)}},
+        {0x04, "AtRate", {}},
+        {0x05, "RepCap", {}},
+        {0x06, "RepSOC", {}},
+        {0x07, "Age", {}},
+        {0x08, "Temp", {}},
+        {0x09, "VCell", {}},
+        {0x0a, "Current", {}},
+        {0x0b, "AvgCurrent", {}},
+        {0x0c, "QResidual", {}},
+        {0x0d, "MixSOC", {}},
+        {0x0e, "AvSOC", {}},
+        {0x0f, "MixCap", {}},
+        {0x10, "FullCapRep", {}},
+        {0x11, "TTE", {}},
+        {0x12, "QRTable00", {}},
+        {0x13, "FullSocThr", {}},
+        {0x14, "RCell", {}},
+        {0x16, "AvgTA", {}},
+        {0x17, "Cycles", {}},
+        {0x18, "DesignCap", {}},
+        {0x19, "AvgVCell", {}},
+        {0x1a, "MaxMinTemp", {bits("min", 7, 0), bits("max", 15, 8)}},
+        {0x1b, "MaxMinVolt", {bits("min", 7, 0), bits("max", 15, 8)}},
+        {0x1c, "MaxMinCurr", {bits("min", 7, 0), bits("max", 15, 8)}},
+        {0x1d, "Config", {bit("ber", 0), bit("bei", 1), bit("aen", 2), bit("fthrm", 3),
+                          bit("ethrm", 4), bit("commsh", 6), bit("shdn", 7), bit("tex", 8),
+                          bit("ten", 9), bit("ainsh", 10), bit("is", 11), bit("vs", 12),
+                          bit("ts", 13), bit("ss", 14), bit("tsel", 15)}},
+        {0x1e, "IChgTerm", {}},
+        {0x1f, "AvCap", {}},
+        {0x20, "TTF", {}},
+        {0x21, "DevName", {}},
+        {0x22, "QRTable10", {}},
+        {0x23, "FullCapNom", {}},
+        {0x27, "AIN", {}},
+        {0x28, "LearnCfg", {}},
+        {0x29, "FilterCfg", {}},
+        {0x2a, "RelaxCfg", {}},
+        {0x2b, "MiscCfg", {}},
+        {0x2c, "TGain", {}},
+        {0x2d, "TOff", {}},
+        {0x2e, "CGain", {}},
+        {0x2f, "COff", {}},
+        {0x32, "QRTable20", {}},
+        {0x34, "DieTemp", {}},
+        {0x35, "FullCap", {}},
+        {0x38, "RComp0", {}},
+        {0x39, "TempCo", {}},
+        {0x3a, "VEmpty", {bits("v_recover", 6, 0), bits("v_empty", 15, 7)}},
+        {0x3d, "FStat", {bit("dnr", 0), bit("reldt2", 6), bit("fq", 7), bit("edet", 8),
+                         bit("reldt", 9)}},
+        {0x3e, "Timer", {}},
+        {0x3f, "ShdnTimer", {}},
+        {0x42, "QRTable30", {}},
+        {0x45, "dQAcc", {}},
+        {0x46, "dPAcc", {}},
+        {0x4d, "QH", {}},
+};
+static_assert(sortedByAddress(maxfgRegisters) && fieldsFit(maxfgRegisters, 16));
+
+template <size_t N>
+constexpr RegisterMap registerMap(const char *chip, const RegisterDef (&registers)[N]) {
+    return {chip, registers, N};
+}
+
+/*
+ * "tcpci" names a layout, the others are the name nodes of the chips. The eUSB repeater, the
+ * max77779 charger and the s2mpg PMICs have no map: their register layouts aren't public, and a
+ * map that wasn't checked against the datasheet would mislabel the dump, so they stay raw.
+ */
+constexpr RegisterMap registerMaps[] = {
+        registerMap("max1720x", maxfgRegisters),
+        registerMap("tcpci", tcpciRegisters),
+};
+
+bool parseHex(std::string_view *text, uint32_t *value) {
+    if (text->size() > 2 && (*text)[0] == '0' && ((*text)[1] == 'x' || (*text)[1] == 'X'))
+        text->remove_prefix(2);
+
+    const char *end = text->data() + text->size();
+    auto [ptr, ec] = std::from_chars(text->data(), end, *value, 16);
+    if (ec != std::errc())
+        return false;
+    text->remove_prefix(ptr - text->data());
+    return true;
+}
+
+uint32_t fieldValue(const RegisterField &field, uint32_t value) {
+    return (value >> field.shift) & ((1u << field.width) - 1);
+}
+
+}  // namespace
+
+const RegisterMap *findRegisterMap(std::string_view chip) {
+    for (const auto &map : registerMaps) {
+        if (chip == map.chip)
+            return &map;
+    }
+    return nullptr;
+}
+
+const RegisterDef *findRegister(const RegisterMap &map, uint32_t address) {
+    const RegisterDef *end = map.registers + map.count;
+    const RegisterDef *reg = std::lower_bound(map.registers, end, address,
+            [](const RegisterDef &r, uint32_t a) { return r.address < a; });
+    return reg != end && reg->address == address ? reg : nullptr;
+}
+
+bool parseRegisterLine(std::string_view line, uint32_t *address, uint32_t *value) {
+    line = trimmed(line);
+    if (!line.empty() && line.front() == '[')
+        line.remove_prefix(1);
+    if (!parseHex(&line, address) || line.empty() ||
+            (line.front() != ':' && line.front() != ']' && line.front() != '='))
+        return false;
+    line.remove_prefix(1);
+    while (!line.empty() && (line.front() == ' ' || line.front() == '\t' || line.front() == ':'))
+        line.remove_prefix(1);
+    return parseHex(&line, value);
+}
+
+void decodeRegister(const RegisterDef &reg, uint32_t value, std::string *text) {
+    text->append(reg.name);
+    for (const auto &field : reg.fields) {
+        if (!field.name)
+            break;
+        text->push_back(' ');
+        text->append(field.name);
+        text->push_back('=');
+        text->append(std::to_string(fieldValue(field, value)));
+    }
+}
+
+void dumpRegisterFile(const char *title, const char *file, const RegisterMap *map) {
+    if (!map || deltaActive()) {
+        dumpFileContent(title, file);
+        return;
+    }
+
+    std::string content;
+    DumpNode node(file);
+    const bool read = node.ok() && (node.readToString(&content) || !content.empty());
+
+    if (structuredOutput()) {
+        dumpFileValueRecord(title, file, read ? &content : nullptr);
+    } else {
+        dumpPrintf("------ %s (%s) ------\n", title, file);
+    }
+    if (!read)
+        return;
+
+    LineReader lines(content);
+    std::string_view line;
+    std::string text;
+    uint32_t address;
+    uint32_t value;
+
+    while (lines.next(&line)) {
+        const RegisterDef *reg = parseRegisterLine(line, &address, &value)
+                ? findRegister(*map, address) : nullptr;
+
+        if (structuredOutput()) {
+            if (!reg)
+                continue;
+            const std::string key = std::string(title) + "." + reg->name;
+            if (!reg->fields[0].name)
+                dumpRecord(key, value, file);
+            for (const auto &field : reg->fields) {
+                if (!field.name)
+                    break;
+                dumpRecord(key + "." + field.name, fieldValue(field, value), file);
+            }
+            continue;
+        }
+
+        /* The raw line stays as it is, the decoded fields follow it. */
+        text.append(line);
+        if (reg) {
+            text.push_back('\t');
+            decodeRegister(*reg, value, &text);
+        }
+        if (line.data() + line.size() < content.data() + content.size())
+            text.push_back('\n');
+    }
+
+    if (structuredOutput())
+        return;
+
+    if (compressionActive()) {
+        CompressedBlock block;
+        block.append(text.data(), text.size());
+        block.finish();
+        text.clear();
+    }
+    text.push_back('\n');
+    dumpWrite(text.data(), text.size());
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <string_view>
+
+/*
+ * Register maps of the chips whose registers_dump nodes are dumped, so that
+ * every "<address>: <value>" line can be written with the register name and
+ * its decoded bitfields next to the raw value. The maps are constexpr tables
+ * sorted by address, which is checked when they are compiled. Only the TCPC
+ * and the max1720x fuel gauges have one; the eUSB repeater, charger and PMIC
+ * dumps are written raw.
+ */
+constexpr int maxRegisterFields = 16;
+
+struct RegisterField {
+    const char *name;
+    uint8_t shift;
+    uint8_t width;
+};
+
+struct RegisterDef {
+    uint16_t address;
+    const char *name;
+    // Unused entries have no name.
+    RegisterField fields[maxRegisterFields];
+};
+
+struct RegisterMap {
+    const char *chip;
+    const RegisterDef *registers;
+    size_t count;
+};
+
+// The map of |chip|, such as the name node of a charger, or null if there is none.
+const RegisterMap *findRegisterMap(std::string_view chip);
+// The register at |address| in |map|, or null.
+const RegisterDef *findRegister(const RegisterMap &map, uint32_t address);
+
+// Parses a "<address>: <value>" dump line, both hex with or without "0x".
+bool parseRegisterLine(std::string_view line, uint32_t *address, uint32_t *value);
+// Appends "<NAME> field=value ..." for |value| of |reg| to |text|.
+void decodeRegister(const RegisterDef &reg, uint32_t value, std::string *text);
+
+/*
+ * dumpFileContent() of a register dump, with each line of a known register
+ * followed by its decoded fields. In JSON the fields also become typed
+ * records. Delta dumps and chips without a map get the plain file.
+ */
+void dumpRegisterFile(const char *title, const char *file, const RegisterMap *map);
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_runner.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <numeric>
+#include <thread>
+
+#include "dump_power_delta.h"
+#include "dump_power_io.h"
+#include "dump_power_record.h"
+
+using std::chrono::steady_clock;
+
+SectionRunner::SectionRunner(const DumpSection *sections, size_t count, int jobs,
+                             std::vector<SectionProfile> *profiles)
+    : mSections(sections), mCount(count), mJobs(jobs), mProfiles(profiles),
+      mBudgetEnd(steady_clock::time_point::max()), mOrder(count), mSlots(count), mNext(0) {
+    std::iota(mOrder.begin(), mOrder.end(), 0);
+    std::stable_sort(mOrder.begin(), mOrder.end(), [sections](size_t a, size_t b) {
+        return sections[a].priority < sections[b].priority;
+    });
+
+    if (mProfiles) {
+        mProfiles->assign(count, SectionProfile());
+        for (size_t i = 0; i < count; i++)
+            (*mProfiles)[i].name = sections[i].name;
+    }
+}
+
+void SectionRunner::setBudget(steady_clock::time_point end) {
+    mBudgetEnd = end;
+}
+
+void SectionRunner::skipSection(size_t index) {
+    ScopedRecordSection scopedRecords(mSections[index].name);
+
+    if (structuredOutput())
+        dumpMarkerRecord("SKIPPED", "");
+    else
+        dumpPrintf("------ %s: skipped, time budget spent ------\n", mSections[index].name);
+}
+
+void SectionRunner::runSection(size_t index) {
+    if (steady_clock::now() >= mBudgetEnd) {
+        skipSection(index);
+        return;
+    }
+
+    ScopedSectionProfile scopedProfile(mProfiles ? &(*mProfiles)[index] : nullptr);
+    ScopedSectionDeadline scopedDeadline;
+    ScopedRecordSection scopedRecords(mSections[index].name);
+    ScopedDeltaSection scopedDelta(mSections[index].name);
+    mSections[index].dump();
+}
+
+void SectionRunner::worker() {
+    size_t index;
+
+    while ((index = mNext.fetch_add(1)) < mCount) {
+        index = mOrder[index];
+        Slot &slot = mSlots[index];
+        {
+            ScopedSectionOutput scopedOutput(&slot.output);
+            runSection(index);
+        }
+
+        std::lock_guard<std::mutex> lock(mLock);
+        slot.done = true;
+        mDone.notify_all();
+    }
+}
+
+void SectionRunner::run() {
+    /*
+     * A delta dump may drop a section's output at its end, and a budget starts
+     * sections out of table order, so both are always buffered.
+     */
+    if (mJobs <= 1 && !deltaActive() && mBudgetEnd == steady_clock::time_point::max()) {
+        for (size_t i = 0; i < mCount; i++) {
+            SectionOutput output(true);
+            {
+                ScopedSectionOutput scopedOutput(&output);
+                runSection(i);
+            }
+            output.emit();
+        }
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    size_t workerCount = std::min(static_cast<size_t>(mJobs), mCount);
+    for (size_t i = 0; i < workerCount; i++)
+        workers.emplace_back(&SectionRunner::worker, this);
+
+    /* Every run of finished sections at the head of the table goes out together. */
+    std::vector<SectionOutput *> ready;
+    for (size_t next = 0; next < mCount;) {
+        size_t end = next + 1;
+        {
+            std::unique_lock<std::mutex> lock(mLock);
+            mDone.wait(lock, [this, next] { return mSlots[next].done; });
+            while (end < mCount && mSlots[end].done)
+                end++;
+        }
+
+        ready.clear();
+        for (size_t i = next; i < end; i++)
+            ready.push_back(&mSlots[i].output);
+        SectionOutput::emitAll(ready.data(), ready.size());
+        for (size_t i = next; i < end; i++)
+            mSlots[i].output.clear();
+        next = end;
+    }
+
+    for (auto &thread : workers)
+        thread.join();
+}
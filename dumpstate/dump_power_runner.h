@@ -0,0 +1,92 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "dump_power_output.h"
+#include "dump_power_profile.h"
+
+/*
+ * Order in which sections are started. High priority sections are the ones a
+ * bugreport can't do without; optional ones are expensive extras that are
+ * started last, so they are the first to go when the time budget runs out.
+ */
+enum SectionPriority {
+    PRIORITY_HIGH,
+    PRIORITY_NORMAL,
+    PRIORITY_OPTIONAL,
+};
+
+struct DumpSection {
+    const char *name;
+    void (*dump)();
+    SectionPriority priority = PRIORITY_NORMAL;
+};
+
+/*
+ * Runs the dump sections on a pool of worker threads. Each section is buffered
+ * and written to stdout strictly in table order, so the output is identical
+ * to running the sections one after another; sections that are done by the
+ * time their turn comes are written together. With a single job the sections
+ * run inline on the calling thread and their output goes to stdout at the end
+ * of each section, unless this is a delta dump or there is a time budget.
+ *
+ * Sections are started in order of their priority. Once the time budget is
+ * spent, sections that have not started yet are skipped and leave a marker
+ * in their place.
+ *
+ * When |profiles| is given, it receives the cost of every section in table
+ * order.
+ */
+class SectionRunner {
+  public:
+    SectionRunner(const DumpSection *sections, size_t count, int jobs,
+                  std::vector<SectionProfile> *profiles = nullptr);
+    // Skips sections that would start after |end|.
+    void setBudget(std::chrono::steady_clock::time_point end);
+    void run();
+
+  private:
+    struct Slot {
+        SectionOutput output;
+        bool done = false;
+    };
+
+    void worker();
+    void runSection(size_t index);
+    void skipSection(size_t index);
+
+    const DumpSection *mSections;
+    const size_t mCount;
+    const int mJobs;
+    std::vector<SectionProfile> *mProfiles;
+    std::chrono::steady_clock::time_point mBudgetEnd;
+
+    // Section indices in the order they are started.
+    std::vector<size_t> mOrder;
+    std::vector<Slot> mSlots;
+    std::atomic<size_t> mNext;
+    std::mutex mLock;
+    std::condition_variable mDone;
+};
@@ -0,0 +1,351 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_service.h"
+
+#include <errno.h>
+#include <getopt.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <string_view>
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <android-base/strings.h>
+#include <android-base/unique_fd.h>
+#include <cutils/sockets.h>
+
+#include "dump_power_discovery.h"
+#include "dump_power_sections.h"
+
+namespace {
+
+constexpr int listenBacklog = 8;
+constexpr size_t maxRequestSize = 16 * 1024;
+constexpr int requestTimeoutS = 1;
+/* A dump writes every few seconds at most; a longer silence means the child is stuck. */
+constexpr int replyTimeoutS = 30;
+/* Devices come and go in bursts, such as a charger and its PD partner; probe once it settles. */
+constexpr int rediscoverDelayMs = 500;
+constexpr size_t ueventBufferSize = 8 * 1024;
+
+/*
+ * Ends each reply, followed by the exit status of the dump. The NUL keeps it from
+ * being mistaken for text at the end of a dump.
+ */
+constexpr char replyTrailer[] = "\0dump_power status";
+constexpr size_t replyTrailerSize = sizeof(replyTrailer) + 1;
+
+/* Set in the child which dumps a request, until its reply is ended. */
+bool gReplying = false;
+
+/* Uevent actions which change the device topology; "change" events only update values. */
+constexpr const char *topologyActions[] = {"add", "remove", "bind", "unbind", "move"};
+
+bool fillAddress(const char *path, struct sockaddr_un *addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path))
+        return false;
+    strcpy(addr->sun_path, path);
+    return true;
+}
+
+android::base::unique_fd listenSocket(const char *socketPath) {
+    android::base::unique_fd fd;
+
+    if (!socketPath) {
+        fd.reset(android_get_control_socket(serviceSocketName));
+        if (!fd.ok()) {
+            fprintf(stderr, "No %s socket from init\n", serviceSocketName);
+            return fd;
+        }
+    } else {
+        struct sockaddr_un addr;
+        if (!fillAddress(socketPath, &addr)) {
+            fprintf(stderr, "Socket path too long: %s\n", socketPath);
+            return fd;
+        }
+        fd.reset(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+        unlink(socketPath);
+        if (!fd.ok() || bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr))) {
+            fprintf(stderr, "Failed to bind %s: %s\n", socketPath, strerror(errno));
+            fd.reset();
+            return fd;
+        }
+    }
+
+    if (listen(fd, listenBacklog)) {
+        fprintf(stderr, "Failed to listen: %s\n", strerror(errno));
+        fd.reset();
+    }
+    return fd;
+}
+
+android::base::unique_fd ueventSocket() {
+    android::base::unique_fd fd(socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK,
+                                       NETLINK_KOBJECT_UEVENT));
+    struct sockaddr_nl addr = {};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = 1;
+
+    if (fd.ok() && bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)))
+        fd.reset();
+    return fd;
+}
+
+/* Reads the pending uevents. Returns whether one of them added or removed a device. */
+bool drainUevents(int fd) {
+    char buffer[ueventBufferSize];
+    bool changed = false;
+    ssize_t len;
+
+    while ((len = TEMP_FAILURE_RETRY(recv(fd, buffer, sizeof(buffer) - 1, MSG_DONTWAIT))) > 0) {
+        /* Each message starts with "<action>@<devpath>". */
+        buffer[len] = '\0';
+        std::string_view header(buffer);
+        std::string_view action = header.substr(0, header.find('@'));
+        if (action.size() == header.size())
+            continue;
+        for (const char *topologyAction : topologyActions)
+            changed |= action == topologyAction;
+    }
+    return changed;
+}
+
+/* Reads the NUL separated arguments of a request, up to the empty one that ends it. */
+bool readRequest(int fd, std::vector<std::string> *args) {
+    std::string request;
+    char buffer[1024];
+
+    while (true) {
+        size_t end = request.find(std::string_view("\0\0", 2));
+        if (!request.empty() && request[0] == '\0')
+            end = 0;
+        else if (end != std::string::npos)
+            end++;
+        if (end != std::string::npos) {
+            request.resize(end);
+            break;
+        }
+
+        ssize_t len = TEMP_FAILURE_RETRY(read(fd, buffer, sizeof(buffer)));
+        if (len <= 0 || request.size() + len > maxRequestSize)
+            return false;
+        request.append(buffer, len);
+    }
+
+    for (size_t pos = 0; pos < request.size(); pos = request.find('\0', pos) + 1)
+        args->push_back(request.c_str() + pos);
+    return true;
+}
+
+/* Whether |arg| would turn a request into a service or recorder of its own. */
+bool daemonOption(const std::string &arg) {
+    return android::base::StartsWith(arg, "--serve") || arg == "--record";
+}
+
+/*
+ * Runs the request on |conn| in a forked child, whose output goes to the
+ * connection. Its errors stay on the stderr of the service, so they never mix
+ * with the dump.
+ */
+void serveRequest(int conn, int listenFd, int ueventFd, int (*dump)(int argc, char **argv)) {
+    pid_t pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Failed to fork: %s\n", strerror(errno));
+        return;
+    }
+    if (pid > 0)
+        return;
+
+    signal(SIGCHLD, SIG_DFL);
+    close(listenFd);
+    if (ueventFd >= 0)
+        close(ueventFd);
+
+    struct timeval timeout = {requestTimeoutS, 0};
+    setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    std::vector<std::string> args;
+    if (!readRequest(conn, &args))
+        _exit(EXIT_FAILURE);
+
+    dup2(conn, STDOUT_FILENO);
+    close(conn);
+    gReplying = true;
+
+    std::vector<char *> argv;
+    argv.push_back(const_cast<char *>("dump_power"));
+    for (auto &arg : args) {
+        if (daemonOption(arg)) {
+            fprintf(stderr, "%s can't be requested from the dump_power service\n", arg.c_str());
+            endServiceReply(EXIT_FAILURE);
+            _exit(EXIT_FAILURE);
+        }
+        argv.push_back(arg.data());
+    }
+    argv.push_back(nullptr);
+
+    /* The service parsed its own options already. */
+    optind = 0;
+    int status = dump(argv.size() - 1, argv.data());
+    endServiceReply(status);
+    fflush(stderr);
+    _exit(status);
+}
+
+}  // namespace
+
+void endServiceReply(int status) {
+    if (!gReplying)
+        return;
+    gReplying = false;
+
+    std::string trailer(replyTrailer, sizeof(replyTrailer));
+    trailer.push_back(static_cast<char>(status));
+    fflush(stdout);
+    android::base::WriteFully(STDOUT_FILENO, trailer.data(), trailer.size());
+}
+
+int runService(const char *socketPath, int (*dump)(int argc, char **argv)) {
+    android::base::unique_fd listenFd(listenSocket(socketPath));
+    if (!listenFd.ok())
+        return EXIT_FAILURE;
+
+    /* Without uevents a cached topology could go stale, so every dump probes for itself. */
+    android::base::unique_fd ueventFd(ueventSocket());
+    if (ueventFd.ok())
+        enableDiscoveryCache();
+    else
+        fprintf(stderr, "No uevent socket, serving without the discovery cache: %s\n",
+                strerror(errno));
+
+    /* Children are reaped by the kernel; each restores SIGCHLD for the helpers it forks. */
+    signal(SIGCHLD, SIG_IGN);
+
+    /*
+     * The service probes without node deadlines, which would start helper threads,
+     * so that it stays single threaded for fork().
+     */
+    warmTopology();
+    bool stale = false;
+
+    while (true) {
+        struct pollfd fds[] = {
+                {listenFd.get(), POLLIN, 0},
+                {ueventFd.get(), POLLIN, 0},
+        };
+        int ret = poll(fds, ueventFd.ok() ? 2 : 1, stale ? rediscoverDelayMs : -1);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "Failed to poll: %s\n", strerror(errno));
+            return EXIT_FAILURE;
+        }
+
+        if (ueventFd.ok() && (fds[1].revents & POLLIN) && drainUevents(ueventFd)) {
+            invalidateDiscovery();
+            stale = true;
+        }
+
+        /* Probe again once the uevents settled, or right before a request needs it. */
+        if (stale && (ret == 0 || (fds[0].revents & POLLIN))) {
+            warmTopology();
+            stale = false;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            android::base::unique_fd conn(TEMP_FAILURE_RETRY(
+                    accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC)));
+            if (conn.ok())
+                serveRequest(conn, listenFd, ueventFd.get(), dump);
+        }
+    }
+}
+
+bool requestServiceDump(const char *socketPath, const std::vector<std::string> &args,
+                        int *status) {
+    struct sockaddr_un addr;
+    if (!fillAddress(socketPath, &addr))
+        return false;
+
+    android::base::unique_fd fd(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+    if (!fd.ok() || TEMP_FAILURE_RETRY(connect(fd, reinterpret_cast<struct sockaddr *>(&addr),
+                                               sizeof(addr))))
+        return false;
+
+    std::string request;
+    for (const auto &arg : args) {
+        request += arg;
+        request += '\0';
+    }
+    request += '\0';
+    if (!android::base::WriteFully(fd, request.data(), request.size()))
+        return false;
+
+    struct timeval timeout = {replyTimeoutS, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    /* The last bytes read may be the trailer, so they are held back until more arrive. */
+    char buffer[32 * 1024];
+    std::string held;
+    size_t total = 0;
+    ssize_t len;
+    fflush(stdout);
+    while ((len = TEMP_FAILURE_RETRY(read(fd, buffer, sizeof(buffer)))) > 0) {
+        held.append(buffer, len);
+        if (held.size() <= replyTrailerSize)
+            continue;
+        const size_t out = held.size() - replyTrailerSize;
+        if (!android::base::WriteFully(STDOUT_FILENO, held.data(), out)) {
+            *status = EXIT_FAILURE;
+            return true;
+        }
+        held.erase(0, out);
+        total += out;
+    }
+
+    if (len == 0 && held.size() == replyTrailerSize &&
+            !held.compare(0, sizeof(replyTrailer), replyTrailer, sizeof(replyTrailer))) {
+        *status = static_cast<unsigned char>(held.back());
+        /* A dump which failed before writing anything, such as on bad arguments, runs here. */
+        return total > 0 || *status == EXIT_SUCCESS;
+    }
+
+    /* Nothing back means the service failed before dumping, so a local dump is still owed. */
+    if (total == 0 && held.empty())
+        return false;
+
+    const int error = errno;
+    android::base::WriteFully(STDOUT_FILENO, held.data(), held.size());
+    std::string reason = len < 0 && (error == EAGAIN || error == EWOULDBLOCK)
+            ? android::base::StringPrintf("no output for %d s", replyTimeoutS)
+            : len < 0 ? strerror(error) : "ended without its status";
+    fprintf(stdout, "\n------ dump_power service: incomplete dump, %s ------\n", reason.c_str());
+    fprintf(stderr, "Incomplete dump from the dump_power service: %s\n", reason.c_str());
+    fflush(stdout);
+    *status = EXIT_FAILURE;
+    return true;
+}
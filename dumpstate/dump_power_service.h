@@ -0,0 +1,54 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/*
+ * Resident dump_power. dump_power --serve keeps the probed device topology
+ * cached, drops it on uevents that add or remove devices, and answers dump
+ * requests on a local socket. Each request is dumped by a forked child of the
+ * warm service, so a dump starts without probing and can't leave state behind
+ * for the next one.
+ *
+ * A request is the arguments of the dump, each terminated by a NUL, followed
+ * by an empty argument. The reply is the output of the dump, ended by a
+ * trailer with its exit status. A reply cut off before the trailer is an
+ * incomplete dump.
+ */
+constexpr char serviceSocketName[] = "dump_power";
+constexpr char defaultServiceSocket[] = "/dev/socket/dump_power";
+
+/*
+ * Serves dump requests on |socketPath|, or on the socket that init created for
+ * the service if it is null. |dump| is run with the arguments of each request.
+ * Returns only on errors.
+ */
+int runService(const char *socketPath, int (*dump)(int argc, char **argv));
+
+/*
+ * Has the service at |socketPath| run the dump of |args| and copies its output
+ * to stdout, with |status| set to the exit status of the dump. A reply which
+ * stops early is marked incomplete in the output and fails. Returns false if
+ * no service dumped anything, so the caller dumps itself.
+ */
+bool requestServiceDump(const char *socketPath, const std::vector<std::string> &args,
+                        int *status);
+
+// Ends the reply of the service dump run by this process with |status|, if there is one.
+void endServiceReply(int status);
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_table.h"
+
+#include <ctype.h>
+
+#include <charconv>
+
+bool LineReader::next(std::string_view *line) {
+    if (mRest.empty())
+        return false;
+
+    size_t end = mRest.find('\n');
+    if (end == std::string_view::npos) {
+        *line = mRest;
+        mRest = {};
+    } else {
+        *line = mRest.substr(0, end);
+        mRest.remove_prefix(end + 1);
+    }
+    return true;
+}
+
+std::string_view trimmed(std::string_view text) {
+    while (!text.empty() && isspace(static_cast<unsigned char>(text.front())))
+        text.remove_prefix(1);
+    while (!text.empty() && isspace(static_cast<unsigned char>(text.back())))
+        text.remove_suffix(1);
+    return text;
+}
+
+bool parseInt(std::string_view text, int64_t *value) {
+    text = trimmed(text);
+    if (!text.empty() && text.front() == '+')
+        text.remove_prefix(1);
+
+    const char *end = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), end, *value);
+    return ec == std::errc() && ptr == end;
+}
+
+void parseTable(std::string_view content, char separator, std::vector<TableRow> *rows) {
+    LineReader lines(content);
+    std::string_view line;
+
+    rows->clear();
+    while (lines.next(&line)) {
+        TableRow row = {line, line, 0, false};
+        size_t pos = line.find(separator);
+        if (pos != std::string_view::npos) {
+            row.name = line.substr(0, pos);
+            row.text = line.substr(pos + 1);
+        }
+        row.numeric = parseInt(row.text, &row.value);
+        rows->push_back(row);
+    }
+}
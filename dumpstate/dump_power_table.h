@@ -0,0 +1,60 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string_view>
+#include <vector>
+
+/*
+ * Parsers for the small tables of the battery mitigation nodes, such as the
+ * "name: count" lines of irq_dur_cnt or the "code=threshold" pwrwarn nodes.
+ * They work in a single pass over the node content and return views into it,
+ * so the content must outlive the results; nothing is copied or allocated
+ * beyond the capacity of the row vector.
+ */
+
+// Splits text into lines without their '\n', the way std::getline() does.
+class LineReader {
+  public:
+    explicit LineReader(std::string_view text) : mRest(text) {}
+
+    bool next(std::string_view *line);
+
+  private:
+    std::string_view mRest;
+};
+
+// |text| without leading and trailing whitespace.
+std::string_view trimmed(std::string_view text);
+
+// Parses |text|, surrounding whitespace aside, as a decimal integer. False if it is none.
+bool parseInt(std::string_view text, int64_t *value);
+
+struct TableRow {
+    // Text before the separator, or the whole line if it has none.
+    std::string_view name;
+    // Text after the separator as the node has it, or the whole line if it has none.
+    std::string_view text;
+    // |text| as a number, if it is one.
+    int64_t value;
+    bool numeric;
+};
+
+// Decodes every "<name><separator><value>" line of |content| into |rows|.
+void parseTable(std::string_view content, char separator, std::vector<TableRow> *rows);
@@ -0,0 +1,290 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dump_power_tree.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+
+using android::base::StringPrintf;
+
+namespace {
+
+constexpr char mitigationDir[] = "/sys/devices/virtual/pmic/mitigation/";
+
+const char *powerSupplies[] = {
+        "battery", "dc", "dc-mains", "dock", "gcpm", "gcpm_pps", "main-charger", "maxfg",
+        "tcpm-source-psy-i2c-max77759tcpc", "usb", "wireless",
+};
+
+const char *mitigationNames[] = {
+        "smpl_warn", "ocp_cpu1", "ocp_cpu2", "ocp_tpu", "ocp_gpu", "soft_ocp_cpu1",
+        "soft_ocp_cpu2", "soft_ocp_tpu", "soft_ocp_gpu", "vdroop1", "vdroop2", "batoilo",
+        "uvlo1", "uvlo2",
+};
+
+const char *votableNames[] = {
+        "MSC_FCC", "MSC_FV", "MSC_USB", "MSC_PCM", "CHARGER_DISABLE", "DC_ICL", "DC_SUSPEND",
+        "GCPM_FCC", "GCPM_FV", "USB_ICL", "WLC_ICL", "TEMP_DRYRUN",
+};
+
+const char *tcpcAttributes[] = {
+        "auto_discharge", "bc12_enabled", "cc_toggle_enable", "contaminant_detection",
+        "contaminant_detection_status", "frs", "irq_hpd_count", "non_compliant_reasons",
+        "registers", "sbu_pullup", "update_sdp_enum_timeout", "usb_limit_accessory_current",
+        "usb_limit_accessory_enable", "usb_limit_sink_current", "usb_limit_sink_enable",
+        "usb_limit_source_enable",
+};
+
+const char *logbuffers[] = {
+        "logbuffer_bd", "logbuffer_cpm", "logbuffer_ln8411", "logbuffer_maxfg",
+        "logbuffer_maxfg_monitor", "logbuffer_maxq", "logbuffer_pca9468", "logbuffer_rtx",
+        "logbuffer_ssoc", "logbuffer_tcpm", "logbuffer_ttf", "logbuffer_usbpd",
+        "logbuffer_wc68", "logbuffer_wireless",
+};
+
+/* The IRQ duration table has 9 channels without ODPM, then 12 channels of each PMIC. */
+constexpr int irqChannels = 9;
+constexpr int odpmChannels = 12;
+
+class TreeWriter {
+  public:
+    explicit TreeWriter(const std::string &root) : mRoot(root) {}
+
+    bool ok() const { return mOk; }
+
+    void dir(const std::string &path) {
+        std::string full = mRoot;
+
+        for (size_t pos = 0; pos != std::string::npos;) {
+            size_t next = path.find('/', pos + 1);
+            full += path.substr(pos, next - pos);
+            if (mkdir(full.c_str(), 0755) && errno != EEXIST)
+                fail(full);
+            pos = next;
+        }
+    }
+
+    void file(const std::string &path, const std::string &content) {
+        dir(path.substr(0, path.rfind('/')));
+        if (!android::base::WriteStringToFile(content, mRoot + path))
+            fail(mRoot + path);
+    }
+
+  private:
+    void fail(const std::string &path) {
+        if (mOk)
+            fprintf(stderr, "Failed to create %s: %s\n", path.c_str(), strerror(errno));
+        mOk = false;
+    }
+
+    const std::string mRoot;
+    bool mOk = true;
+};
+
+std::string uevent(const char *name, int seed) {
+    return StringPrintf("POWER_SUPPLY_NAME=%s\n"
+                        "POWER_SUPPLY_TYPE=Battery\n"
+                        "POWER_SUPPLY_STATUS=Charging\n"
+                        "POWER_SUPPLY_HEALTH=Good\n"
+                        "POWER_SUPPLY_PRESENT=1\n"
+                        "POWER_SUPPLY_ONLINE=1\n"
+                        "POWER_SUPPLY_CAPACITY=%d\n"
+                        "POWER_SUPPLY_CURRENT_NOW=%d\n"
+                        "POWER_SUPPLY_CURRENT_MAX=3000000\n"
+                        "POWER_SUPPLY_VOLTAGE_NOW=%d\n"
+                        "POWER_SUPPLY_VOLTAGE_MAX=4450000\n"
+                        "POWER_SUPPLY_TEMP=%d\n"
+                        "POWER_SUPPLY_CHARGE_COUNTER=%d\n"
+                        "POWER_SUPPLY_CHARGE_FULL=4805000\n"
+                        "POWER_SUPPLY_CHARGE_FULL_DESIGN=4950000\n"
+                        "POWER_SUPPLY_CYCLE_COUNT=%d\n"
+                        "POWER_SUPPLY_TIME_TO_FULL_NOW=%d\n",
+                        name, 40 + seed % 60, -500000 + seed * 1000, 3900000 + seed * 100,
+                        250 + seed % 100, 2000000 + seed * 10, seed % 800, seed * 60);
+}
+
+/* Lines in the format of the kernel logbuffers, up to |bytes|. */
+std::string logbuffer(const char *name, size_t bytes) {
+    std::string content;
+
+    for (int line = 0; content.size() < bytes; line++) {
+        content += StringPrintf("[%6d.%06d] %s: MSC_DSG vbatt=%d ibatt=%d fv_uv=4450000"
+                                " cc_max=%d soc=%d temp=%d\n",
+                                line / 10, (line * 37) % 1000000, name, 3900000 + line % 5000,
+                                -500000 + line % 1000, 3000000 - line % 7, line % 100,
+                                250 + line % 50);
+    }
+    content.resize(bytes);
+    return content;
+}
+
+std::string mitigationName(int index) {
+    const int named = sizeof(mitigationNames) / sizeof(mitigationNames[0]);
+
+    if (index < named)
+        return mitigationNames[index];
+    return StringPrintf("%s_%d", mitigationNames[index % named], index / named);
+}
+
+void buildPowerSupplies(TreeWriter &tree) {
+    int seed = 0;
+
+    for (const char *supply : powerSupplies)
+        tree.file(StringPrintf("/sys/class/power_supply/%s/uevent", supply), uevent(supply, seed++));
+
+    const char *batteryNodes[] = {
+            "health_index_stats", "swelling_data", "ttf_details", "ttf_stats", "aacr_state",
+            "charge_details",
+    };
+    for (const char *node : batteryNodes) {
+        std::string content;
+        for (int i = 0; i < 16; i++)
+            content += StringPrintf("%d: %d %d %d %d\n", i, i * 3, i * 5, i * 7, i * 11);
+        tree.file(std::string("/sys/class/power_supply/battery/") + node, content);
+    }
+
+    std::string registers;
+    for (int reg = 0; reg < 0x100; reg++)
+        registers += StringPrintf("%02x: %04x\n", reg, (reg * 0x1d3) & 0xffff);
+    tree.file("/sys/class/power_supply/maxfg/registers_dump", registers);
+    tree.file("/sys/class/power_supply/dc-mains/device/registers_dump", registers);
+    tree.file("/sys/class/power_supply/maxfg/m5_model_state", "m5 state: 0x1234\n");
+    tree.file("/sys/class/power_supply/maxfg/device/name", "max77779fg\n");
+    tree.file("/sys/class/power_supply/wireless/device/version", "0x11\n");
+    tree.file("/sys/class/power_supply/wireless/device/status", "1\n");
+    tree.file("/sys/class/power_supply/wireless/device/fw_rev", "3.4.5\n");
+    tree.file("/sys/class/power_supply/main-charger/device/name", "max77779-charger\n");
+
+    for (const char *attribute : tcpcAttributes)
+        tree.file(std::string("/sys/class/typec/port0/device/") + attribute, "0\n");
+}
+
+void buildLogbuffers(TreeWriter &tree, const NodeTreeScale &scale) {
+    for (const char *name : logbuffers)
+        tree.file(std::string("/dev/") + name, logbuffer(name, scale.logbufferBytes));
+    tree.file("/sys/kernel/debug/tcpm/tcpm-source-psy-i2c-max77759tcpc",
+              logbuffer("tcpm", scale.logbufferBytes));
+}
+
+void buildMitigation(TreeWriter &tree, const NodeTreeScale &scale) {
+    const std::string dir = mitigationDir;
+
+    for (int i = 0; i < scale.mitigationSources; i++) {
+        const std::string name = mitigationName(i);
+        tree.file(dir + "last_triggered_count/" + name + "_count", StringPrintf("%d\n", i * 3));
+        tree.file(dir + "last_triggered_capacity/" + name + "_cap", StringPrintf("%d\n", i % 100));
+        tree.file(dir + "last_triggered_timestamp/" + name + "_time",
+                  StringPrintf("%d\n", 1000 + i * 17));
+        tree.file(dir + "last_triggered_voltage/" + name + "_volt",
+                  StringPrintf("%d\n", 3400 + i % 600));
+        tree.file(dir + "clock_ratio/" + name + "_ratio", StringPrintf("0x%x\n", i % 16));
+        tree.file(dir + "clock_stats/" + name + "_stats", StringPrintf("%d\n", i * 101));
+        tree.file(dir + "triggered_lvl/" + name + "_lvl", StringPrintf("%d\n", 6000 + i));
+        tree.file(dir + "instruction/" + name, StringPrintf("0x%08x\n", i * 0x10001));
+    }
+
+    const char *durations[] = {
+            "less_than_5ms_count", "between_5ms_to_10ms_count", "greater_than_10ms_count",
+    };
+    for (int d = 0; d < 3; d++) {
+        std::string content;
+        for (int i = 0; i < irqChannels + 2 * odpmChannels; i++) {
+            std::string name = i < irqChannels ? mitigationName(i)
+                                               : StringPrintf("odpm_ch%d", i - irqChannels);
+            content += StringPrintf("%s: %d\n", name.c_str(), (i + 1) * (d + 1));
+        }
+        tree.file(dir + "irq_dur_cnt/" + durations[d], content);
+    }
+
+    const char *pwrwarn[] = {"main_pwrwarn", "sub_pwrwarn"};
+    const char *lpfCurrent[] = {
+            "/sys/devices/platform/acpm_mfd_bus@15500000/i2c-7/7-001f/s2mpg14-meter/"
+                    "s2mpg14-odpm/iio:device1/lpf_current",
+            "/sys/devices/platform/acpm_mfd_bus@15510000/i2c-8/8-002f/s2mpg15-meter/"
+                    "s2mpg15-odpm/iio:device0/lpf_current",
+    };
+    for (int pmic = 0; pmic < 2; pmic++) {
+        std::string current = StringPrintf("t=%d\n", 123456 + pmic);
+        for (int ch = 0; ch < odpmChannels; ch++) {
+            tree.file(StringPrintf("%s%s/%s_ch%d", mitigationDir, pwrwarn[pmic], pwrwarn[pmic],
+                                   ch),
+                      StringPrintf("%d=%d\n", ch, 100000 * (ch + 1)));
+            current += StringPrintf("CH%d[VSYS_PWR_%d] %d\n", ch, ch, 5000 * (ch + 1));
+        }
+        tree.file(lpfCurrent[pmic], current);
+    }
+
+    tree.file("/data/vendor/mitigation/lastmeal.csv", "time,source,soc,volt\n1,uvlo1,50,3400\n");
+    tree.file("/data/vendor/mitigation/lastmeal.txt", "uvlo1 triggered\n");
+}
+
+void buildVotables(TreeWriter &tree, const NodeTreeScale &scale) {
+    const int named = sizeof(votableNames) / sizeof(votableNames[0]);
+
+    for (int i = 0; i < scale.votables; i++) {
+        std::string name = i < named ? votableNames[i]
+                                     : StringPrintf("%s_%d", votableNames[i % named], i / named);
+        /* The section dumps the status text as is; only its size is modeled, not its layout. */
+        std::string status;
+        for (int voter = 0; voter < 4; voter++)
+            status += StringPrintf("VOTER_%d %d\n", voter, 1000 * (i + voter + 1));
+        tree.file("/sys/kernel/debug/gvotables/" + name + "/status", status);
+    }
+}
+
+void buildMisc(TreeWriter &tree) {
+    std::string histogram;
+    for (int cpu = 0; cpu < 8; cpu++) {
+        histogram += StringPrintf("cpu%d\n", cpu);
+        for (int state = 0; state < 3; state++) {
+            histogram += StringPrintf("state%d:", state);
+            for (int bucket = 0; bucket < 20; bucket++)
+                histogram += StringPrintf(" %d", (cpu + 1) * (state + 1) * (bucket + 1) * 13);
+            histogram += "\n";
+        }
+    }
+    tree.file("/sys/kernel/metrics/cpuidle_histogram/cpuidle_histogram", histogram);
+    tree.file("/sys/kernel/metrics/cpuidle_histogram/cpucluster_histogram", histogram);
+
+    const char *acpmStats[] = {"core_stats", "mif_stats", "slc_stats", "tpu_stats"};
+    for (const char *stats : acpmStats)
+        tree.file(std::string("/sys/devices/platform/acpm_stats/") + stats,
+                  "state count total_time_ns last_entry_ns\n0 12 34567 890\n1 3 4567 89\n");
+
+    tree.file("/sys/devices/system/cpu/cpupm/cpupm/time_in_state", histogram);
+    tree.file("/d/pm_genpd/pm_genpd_summary", "domain status children\npd-tpu off\n");
+    tree.file("/sys/devices/platform/10c90000.hsi2c/i2c-9/9-0050/eeprom", std::string(256, 'B'));
+}
+
+}  // namespace
+
+bool buildNodeTree(const std::string &root, const NodeTreeScale &scale) {
+    TreeWriter tree(root);
+
+    tree.dir("");
+    buildPowerSupplies(tree);
+    buildLogbuffers(tree, scale);
+    buildMitigation(tree, scale);
+    buildVotables(tree, scale);
+    buildMisc(tree);
+    return tree.ok();
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include <string>
+
+/*
+ * Synthetic node tree for dump_power. The tree mirrors the sysfs, debugfs
+ * and logbuffer layout that the sections read, with power supplies, the
+ * battery mitigation directories, logbuffers and gvotables, and is read by
+ * dump_power --root. The scale sets how much data the heavy sections find.
+ */
+struct NodeTreeScale {
+    // Sources in each battery mitigation directory.
+    int mitigationSources = 64;
+    // Votables under gvotables.
+    int votables = 40;
+    // Size of every logbuffer.
+    size_t logbufferBytes = 64 * 1024;
+};
+
+// Builds the tree below |root|, which is created if missing. Returns false on errors.
+bool buildNodeTree(const std::string &root, const NodeTreeScale &scale);
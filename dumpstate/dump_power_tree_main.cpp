@@ -0,0 +1,75 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dump_power_tree.h"
+
+/* Builds a synthetic node tree for dump_power --root and the benchmarks. */
+
+static void usage(const char *name) {
+    const NodeTreeScale scale;
+
+    fprintf(stderr, "Usage: %s [--mitigation-sources N] [--votables N] [--logbuffer-kb KB] ROOT\n",
+            name);
+    fprintf(stderr, "  --mitigation-sources N\n"
+            "                  sources in each battery mitigation directory (default %d)\n",
+            scale.mitigationSources);
+    fprintf(stderr, "  --votables N    votables under gvotables (default %d)\n", scale.votables);
+    fprintf(stderr, "  --logbuffer-kb KB\n"
+            "                  size of every logbuffer (default %zu)\n",
+            scale.logbufferBytes / 1024);
+}
+
+int main(int argc, char **argv) {
+    const struct option options[] = {
+            {"mitigation-sources", required_argument, nullptr, 'm'},
+            {"votables", required_argument, nullptr, 'v'},
+            {"logbuffer-kb", required_argument, nullptr, 'l'},
+            {"help", no_argument, nullptr, 'h'},
+            {nullptr, 0, nullptr, 0},
+    };
+    NodeTreeScale scale;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "h", options, nullptr)) != -1) {
+        switch (opt) {
+        case 'm':
+            scale.mitigationSources = atoi(optarg);
+            break;
+        case 'v':
+            scale.votables = atoi(optarg);
+            break;
+        case 'l':
+            scale.logbufferBytes = static_cast<size_t>(atoi(optarg)) * 1024;
+            break;
+        case 'h':
+            usage(argv[0]);
+            return EXIT_SUCCESS;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (optind != argc - 1 || scale.mitigationSources < 0 || scale.votables < 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    return buildNodeTree(argv[optind], scale) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SnapshotStateResidencyDataProvider.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace power {
+namespace stats {
+
+FileSnapshot::FileSnapshot(const std::string &path) : kPath(path), mSnapshotPath(path) {
+    mFd.reset(memfd_create("powerstats_snapshot", MFD_CLOEXEC));
+    if (!mFd.ok()) {
+        PLOG(ERROR) << "Failed to create snapshot of " << kPath << ", reading it directly";
+        return;
+    }
+
+    // Reopening the memfd through procfs gives each open its own offset
+    mSnapshotPath = "/proc/self/fd/" + std::to_string(mFd.get());
+    refresh();
+}
+
+void FileSnapshot::refresh() {
+    std::string content;
+
+    if (!mFd.ok()) {
+        return;
+    }
+
+    if (!::android::base::ReadFileToString(kPath, &content)) {
+        PLOG(ERROR) << "Failed to read " << kPath;
+        content.clear();
+    }
+
+    // An empty copy fails to parse just like the unreadable file would
+    if (ftruncate(mFd.get(), 0) ||
+        !::android::base::WriteFully(mFd.get(), content.data(), content.size()) ||
+        lseek(mFd.get(), 0, SEEK_SET)) {
+        PLOG(ERROR) << "Failed to update snapshot of " << kPath;
+    }
+}
+
+SnapshotStateResidencyDataProvider::SnapshotStateResidencyDataProvider(const std::string &path)
+    : mSnapshot(path) {}
+
+void SnapshotStateResidencyDataProvider::addProvider(
+        std::unique_ptr<PowerStats::IStateResidencyDataProvider> provider) {
+    mProviders.emplace_back(std::move(provider));
+}
+
+bool SnapshotStateResidencyDataProvider::getStateResidencies(
+        std::unordered_map<std::string, std::vector<StateResidency>> *residencies) {
+    std::lock_guard<std::mutex> lock(mLock);
+    bool ret = true;
+
+    // PowerStats calls a provider once per request, so this is the one read of the request
+    mSnapshot.refresh();
+    for (const auto &provider : mProviders) {
+        ret &= provider->getStateResidencies(residencies);
+    }
+    return ret;
+}
+
+std::unordered_map<std::string, std::vector<State>> SnapshotStateResidencyDataProvider::getInfo() {
+    std::lock_guard<std::mutex> lock(mLock);
+    std::unordered_map<std::string, std::vector<State>> info;
+
+    for (const auto &provider : mProviders) {
+        info.merge(provider->getInfo());
+    }
+    return info;
+}
+
+}  // namespace stats
+}  // namespace power
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -20,6 +20,7 @@
 #include <CpupmStateResidencyDataProvider.h>
 #include <DevfreqStateResidencyDataProvider.h>
 #include <DisplayMrrStateResidencyDataProvider.h>
+#include <SnapshotStateResidencyDataProvider.h>
 #include <AdaptiveDvfsStateResidencyDataProvider.h>
 #include <TpuDvfsStateResidencyDataProvider.h>
 #include <UfsStateResidencyDataProvider.h>
@@ -36,6 +37,8 @@
 #include <log/log.h>
 #include <sys/stat.h>
 
+#include <map>
+
 using aidl::android::hardware::power::stats::AdaptiveDvfsStateResidencyDataProvider;
 using aidl::android::hardware::power::stats::AocStateResidencyDataProvider;
 using aidl::android::hardware::power::stats::CpupmStateResidencyDataProvider;
@@ -48,6 +51,7 @@ using aidl::android::hardware::power::stats::GenericStateResidencyDataProvider;
 using aidl::android::hardware::power::stats::IioEnergyMeterDataProvider;
 using aidl::android::hardware::power::stats::PixelStateResidencyDataProvider;
 using aidl::android::hardware::power::stats::PowerStatsEnergyConsumer;
+using aidl::android::hardware::power::stats::SnapshotStateResidencyDataProvider;
 using aidl::android::hardware::power::stats::TpuDvfsStateResidencyDataProvider;
 
 // TODO (b/181070764) (b/182941084):
@@ -109,6 +113,29 @@ void addPlaceholderEnergyConsumers(std::shared_ptr<PowerStats> p) {
             std::make_unique<PlaceholderEnergyConsumer>(p, EnergyConsumerType::BLUETOOTH, "BT"));
 }
 
+/**
+ * ACPM stats files which more than one provider parses are read once per getStateResidency
+ * request through a snapshot shared by all of them. The providers are collected here and added
+ * to PowerStats together by addAcpmSnapshots().
+ */
+static std::map<std::string, std::unique_ptr<SnapshotStateResidencyDataProvider>> acpmSnapshots;
+
+static SnapshotStateResidencyDataProvider *getAcpmSnapshot(const std::string &name) {
+    auto &snapshot = acpmSnapshots[name];
+    if (!snapshot) {
+        snapshot = std::make_unique<SnapshotStateResidencyDataProvider>(
+                "/sys/devices/platform/acpm_stats/" + name);
+    }
+    return snapshot.get();
+}
+
+static void addAcpmSnapshots(std::shared_ptr<PowerStats> p) {
+    for (auto &[name, snapshot] : acpmSnapshots) {
+        p->addStateResidencyDataProvider(std::move(snapshot));
+    }
+    acpmSnapshots.clear();
+}
+
 void addAoC(std::shared_ptr<PowerStats> p) {
     // AoC clock is synced from "libaoc.c"
     static const uint64_t AOC_CLOCK = 24576;
@@ -169,7 +196,7 @@ void addAoC(std::shared_ptr<PowerStats> p) {
 void addDvfsStats(std::shared_ptr<PowerStats> p) {
     // A constant to represent the number of nanoseconds in one millisecond
     const int NS_TO_MS = 1000000;
-    std::string path = "/sys/devices/platform/acpm_stats/fvp_stats";
+    auto fvpStats = getAcpmSnapshot("fvp_stats");
 
     std::vector<std::pair<std::string, std::string>> adpCfgs = {
         std::make_pair("CL0", "/sys/devices/system/cpu/cpufreq/policy0/stats"),
@@ -178,8 +205,8 @@ void addDvfsStats(std::shared_ptr<PowerStats> p) {
         std::make_pair("MIF",
                 "/sys/devices/platform/17000010.devfreq_mif/devfreq/17000010.devfreq_mif")};
 
-    p->addStateResidencyDataProvider(std::make_unique<AdaptiveDvfsStateResidencyDataProvider>(
-            path, NS_TO_MS, adpCfgs));
+    fvpStats->addProvider(std::make_unique<AdaptiveDvfsStateResidencyDataProvider>(
+            fvpStats->path(), NS_TO_MS, adpCfgs));
 
     std::vector<DvfsStateResidencyDataProvider::Config> cfgs;
     cfgs.push_back({"AUR", {
@@ -192,8 +219,8 @@ void addDvfsStats(std::shared_ptr<PowerStats> p) {
         std::make_pair("178MHz", "178000"),
     }});
 
-    p->addStateResidencyDataProvider(std::make_unique<DvfsStateResidencyDataProvider>(
-            path, NS_TO_MS, cfgs));
+    fvpStats->addProvider(
+            std::make_unique<DvfsStateResidencyDataProvider>(fvpStats->path(), NS_TO_MS, cfgs));
 
     // TPU DVFS
     const int TICK_TO_MS = 100;
@@ -277,8 +304,9 @@ void addSoC(std::shared_ptr<PowerStats> p) {
     cfgs.emplace_back(generateGenericStateResidencyConfigs(reqStateConfig, slcReqStateHeaders),
             "SLC-REQ", "SLC_REQ:");
 
-    p->addStateResidencyDataProvider(std::make_unique<GenericStateResidencyDataProvider>(
-            "/sys/devices/platform/acpm_stats/soc_stats", cfgs));
+    auto socStats = getAcpmSnapshot("soc_stats");
+    socStats->addProvider(
+            std::make_unique<GenericStateResidencyDataProvider>(socStats->path(), cfgs));
 }
 
 void setEnergyMeter(std::shared_ptr<PowerStats> p) {
@@ -334,9 +362,10 @@ void addCPUclusters(std::shared_ptr<PowerStats> p) {
 
     CpupmStateResidencyDataProvider::SleepConfig sleepConfig = {"LPM:", "SLEEP", "total_time_ns:"};
 
-    p->addStateResidencyDataProvider(std::make_unique<CpupmStateResidencyDataProvider>(
-            "/sys/devices/system/cpu/cpupm/cpupm/time_in_state", config,
-            "/sys/devices/platform/acpm_stats/soc_stats", sleepConfig));
+    auto socStats = getAcpmSnapshot("soc_stats");
+    socStats->addProvider(std::make_unique<CpupmStateResidencyDataProvider>(
+            "/sys/devices/system/cpu/cpupm/cpupm/time_in_state", config, socStats->path(),
+            sleepConfig));
 
     p->addEnergyConsumer(PowerStatsEnergyConsumer::createMeterConsumer(p,
             EnergyConsumerType::CPU_CLUSTER, "CPUCL0", {"S4M_VDD_CPUCL0"}));
@@ -673,6 +702,7 @@ void addZumaCommonDataProviders(std::shared_ptr<PowerStats> p) {
     addDvfsStats(p);
     addDevfreq(p);
     addGPU(p);
+    addAcpmSnapshots(p);
 }
 
 void addNFC(std::shared_ptr<PowerStats> p) {
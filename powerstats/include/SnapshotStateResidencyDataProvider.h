@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <PowerStatsAidl.h>
+
+#include <android-base/unique_fd.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace power {
+namespace stats {
+
+/**
+ * A copy of one file, like the ACPM stats nodes, which several providers parse. The providers
+ * open path() instead of the file itself and see whatever refresh() read last.
+ */
+class FileSnapshot {
+  public:
+    explicit FileSnapshot(const std::string &path);
+
+    // The path the providers are given in place of the backing file
+    const std::string &path() const { return mSnapshotPath; }
+
+    // Reads the backing file into the copy again
+    void refresh();
+
+  private:
+    const std::string kPath;
+    std::string mSnapshotPath;
+    ::android::base::unique_fd mFd;
+};
+
+/**
+ * Runs every provider that parses one file as a single provider, so that all of them see the
+ * same copy of the file, read once per getStateResidency request. Providers are added before
+ * this is added to PowerStats, and read the file through path().
+ */
+class SnapshotStateResidencyDataProvider : public PowerStats::IStateResidencyDataProvider {
+  public:
+    explicit SnapshotStateResidencyDataProvider(const std::string &path);
+    ~SnapshotStateResidencyDataProvider() = default;
+
+    // The path the providers are given in place of the backing file
+    const std::string &path() const { return mSnapshot.path(); }
+
+    void addProvider(std::unique_ptr<PowerStats::IStateResidencyDataProvider> provider);
+
+    /*
+     * See IStateResidencyDataProvider::getStateResidencies
+     */
+    bool getStateResidencies(
+        std::unordered_map<std::string, std::vector<StateResidency>> *residencies) override;
+
+    /*
+     * See IStateResidencyDataProvider::getInfo
+     */
+    std::unordered_map<std::string, std::vector<State>> getInfo() override;
+
+  private:
+    FileSnapshot mSnapshot;
+    std::vector<std::unique_ptr<PowerStats::IStateResidencyDataProvider>> mProviders;
+    std::mutex mLock;
+};
+
+}  // namespace stats
+}  // namespace power
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl